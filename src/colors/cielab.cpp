@@ -22,7 +22,20 @@
  */
 
 #include "cielab.h"
+#include "../threads/thread_pool.h"
 #include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CIELAB_SSE2
+#include <emmintrin.h>
+#endif
+
+// Number of colors converted at once by the batch conversion
+#define CIELAB_BATCH_CHUNK (256)
+
+// Min number of colors per thread in the batch conversion
+#define CIELAB_BATCH_MIN_PER_THREAD (16384)
 
 using namespace cielab;
 using namespace colors;
@@ -78,6 +91,167 @@ void cielab::rgbToLab(colors::Color color, Lab * lab) {
     xyzToLab(&xyz, lab);
 }
 
+/* Batch conversion */
+
+/**
+ * @brief  sRGB linearization table (same values as xyzParseRGBComponent)
+ * @note   
+ * @retval None
+ */
+struct LinearizationTable {
+    double values[256];
+
+    LinearizationTable() {
+        for (int i = 0; i < 256; i++) {
+            values[i] = xyzParseRGBComponent(static_cast<unsigned char>(i));
+        }
+    }
+};
+
+const LinearizationTable &getLinearizationTable() {
+    static const LinearizationTable table;
+    return table;
+}
+
+/**
+ * @brief  Fast cube root for the L*ab conversion
+ * @note   Starts with x^(1/4) scaled (less than 22% of relative error for
+ *         0.008856 < x < 1.1, the range where it is used), then 3 iterations of
+ *         Halley's method (cubic convergence) get close to double precision.
+ * @param  x: Value (x > 0)
+ * @retval Cube root of x
+ */
+inline double fastCubeRoot(double x) {
+    double y = 0.824 * sqrt(sqrt(x));
+    double y3;
+
+    for (int i = 0; i < 3; i++) {
+        y3 = (y * y) * y;
+        y = (y * (y3 + 2 * x)) / ((2 * y3) + x);
+    }
+
+    return y;
+}
+
+inline double labParseXYZComponentFast(double value) {
+    if (value > 0.008856) {
+        return fastCubeRoot(value);
+    } else {
+        return (7.787 * value) + (0.13793103448275862);
+    }
+}
+
+#if defined(CIELAB_SSE2)
+
+/**
+ * @brief  Same as labParseXYZComponentFast, for 2 values
+ * @note   Same operations, so the results are the same
+ * @param  value: Values
+ * @retval Results
+ */
+inline __m128d labParseXYZComponentSSE2(__m128d value) {
+    __m128d one = _mm_set1_pd(1.0);
+    __m128d two = _mm_set1_pd(2.0);
+
+    __m128d above = _mm_cmpgt_pd(value, _mm_set1_pd(0.008856));
+
+    // Cube root (with 1 for the values that use the linear part)
+    __m128d x = _mm_or_pd(_mm_and_pd(above, value), _mm_andnot_pd(above, one));
+    __m128d y = _mm_mul_pd(_mm_set1_pd(0.824), _mm_sqrt_pd(_mm_sqrt_pd(x)));
+    __m128d y3;
+
+    for (int i = 0; i < 3; i++) {
+        y3 = _mm_mul_pd(_mm_mul_pd(y, y), y);
+        y = _mm_div_pd(_mm_mul_pd(y, _mm_add_pd(y3, _mm_mul_pd(two, x))), _mm_add_pd(_mm_mul_pd(two, y3), x));
+    }
+
+    __m128d linear = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(7.787), value), _mm_set1_pd(0.13793103448275862));
+
+    return _mm_or_pd(_mm_and_pd(above, y), _mm_andnot_pd(above, linear));
+}
+
+#endif
+
+void rgbToLabChunk(const Color * colors, Lab * labs, size_t n) {
+    const double * table = getLinearizationTable().values;
+
+    double xs[CIELAB_BATCH_CHUNK];
+    double ys[CIELAB_BATCH_CHUNK];
+    double zs[CIELAB_BATCH_CHUNK];
+
+    // Same as rgbToXYZ, with the table
+    for (size_t i = 0; i < n; i++) {
+        double r = table[colors[i].red];
+        double g = table[colors[i].green];
+        double b = table[colors[i].blue];
+
+        xs[i] = (r * 0.4124 + g * 0.3576 + b * 0.1805) / 95.047;
+        ys[i] = (r * 0.2126 + g * 0.7152 + b * 0.0722) / 100.0;
+        zs[i] = (r * 0.0193 + g * 0.1192 + b * 0.9505) / 108.883;
+    }
+
+    // Cube roots
+    size_t i = 0;
+
+#if defined(CIELAB_SSE2)
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(xs + i, labParseXYZComponentSSE2(_mm_loadu_pd(xs + i)));
+        _mm_storeu_pd(ys + i, labParseXYZComponentSSE2(_mm_loadu_pd(ys + i)));
+        _mm_storeu_pd(zs + i, labParseXYZComponentSSE2(_mm_loadu_pd(zs + i)));
+    }
+#endif
+
+    for (; i < n; i++) {
+        xs[i] = labParseXYZComponentFast(xs[i]);
+        ys[i] = labParseXYZComponentFast(ys[i]);
+        zs[i] = labParseXYZComponentFast(zs[i]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        labs[i].L = (ys[i] * 116) - 16;
+        labs[i].a = 500 * (xs[i] - ys[i]);
+        labs[i].b = 200 * (ys[i] - zs[i]);
+    }
+}
+
+void cielab::rgbToLab(const colors::Color * colors, colors::Lab * labs, size_t n) {
+    for (size_t i = 0; i < n; i += CIELAB_BATCH_CHUNK) {
+        size_t chunk = n - i;
+
+        if (chunk > CIELAB_BATCH_CHUNK) {
+            chunk = CIELAB_BATCH_CHUNK;
+        }
+
+        rgbToLabChunk(colors + i, labs + i, chunk);
+    }
+}
+
+void threadRgbToLab(const Color * colors, Lab * labs, size_t n) {
+    cielab::rgbToLab(colors, labs, n);
+}
+
+void cielab::rgbToLab(const colors::Color * colors, colors::Lab * labs, size_t n, size_t threadNum) {
+    size_t maxThreads = n / CIELAB_BATCH_MIN_PER_THREAD;
+
+    if (threadNum > maxThreads) {
+        threadNum = maxThreads;
+    }
+
+    if (threadNum <= 1) {
+        rgbToLab(colors, labs, n);
+        return;
+    }
+
+    size_t amountPerThread = n / threadNum;
+
+    threading::getThreadPool().run(threadNum, [&](size_t i) {
+        size_t start = i * amountPerThread;
+        size_t end = (i == threadNum - 1) ? n : (start + amountPerThread);
+
+        threadRgbToLab(colors + start, labs + start, end - start);
+    });
+}
+
 double cielab::deltaE(colors::Color colorA, colors::Color colorB) {
     Lab a;
     Lab b;
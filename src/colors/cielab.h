@@ -24,6 +24,10 @@
 #pragma once
 
 #include "colors.h"
+#include <cstddef>
+
+// Max absolute error of L, a and b in the batch conversion (compared to rgbToLab)
+#define CIELAB_BATCH_EPSILON (1e-9)
 
 /**
  * @brief  CIE L*ab colors utils
@@ -58,6 +62,28 @@ namespace cielab {
      */
     void rgbToLab(colors::Color color, colors::Lab * lab);
 
+    /**
+     * @brief  RGB colors to L*ab (batch)
+     * @note   Uses a table for the sRGB linearization and a fast cube root.
+     *         Results differ from rgbToLab by less than CIELAB_BATCH_EPSILON.
+     * @param  colors: Array of RGB colors
+     * @param  labs: Array to store the results (same size)
+     * @param  n: Number of colors
+     * @retval None
+     */
+    void rgbToLab(const colors::Color * colors, colors::Lab * labs, size_t n);
+
+    /**
+     * @brief  RGB colors to L*ab (batch, multi-threaded)
+     * @note   Same as the single thread version
+     * @param  colors: Array of RGB colors
+     * @param  labs: Array to store the results (same size)
+     * @param  n: Number of colors
+     * @param  threadNum: Max number of threads to use
+     * @retval None
+     */
+    void rgbToLab(const colors::Color * colors, colors::Lab * labs, size_t n, size_t threadNum);
+
     /**
      * @brief  Delta*E color distance algorithm
      * @note   
@@ -145,5 +145,6 @@ colors::Color colors::bendColor(colors::Color color, unsigned char alpha, colors
     result.red = (unsigned char)((a * color.red + inv_a * background.red) >> 8);
     result.green = (unsigned char)((a * color.green + inv_a * background.green) >> 8);
     result.blue = (unsigned char)((a * color.blue + inv_a * background.blue) >> 8);
+    result.unused = 0;
     return result;
 }
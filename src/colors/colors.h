@@ -40,14 +40,17 @@ namespace colors
 
     /**
      * @brief  Color structure (RGB)
-     * @note   
+     * @note   4 bytes (RGBX), aligned, so a pixel is loaded at once
+     *         and the rows of an image can be loaded directly by SIMD code.
+     *         Transparency is stored apart (see mapart::TransparencyMask)
      * @retval None
      */
-    struct Color
+    struct alignas(4) Color
     {
         unsigned char red;
-        unsigned char blue;
         unsigned char green;
+        unsigned char blue;
+        unsigned char unused; // Padding, always 0 in the images
     };
 
     /**
@@ -147,6 +147,13 @@ int printHelp()
     cout << "                                             'bayer-44' (Bayer 4x4)" << endl;
     cout << "                                             'bayer-22' (Bayer 2x2)" << endl;
     cout << "                                             'ordered-33' (Ordered 3x3)" << endl;
+    cout << "                                             'bayer-88' (Bayer 8x8)" << endl;
+    cout << "                                             'bayer-1616' (Bayer 16x16)" << endl;
+    cout << "                                             'blue-noise' (Blue noise 64x64)" << endl;
+    cout << "    -dm, --diffusion-mode [mode]           Sets the scope of the error diffusion dithering methods. By default 'exact'" << endl;
+    cout << "                                             'exact' - The error is diffused through the whole image" << endl;
+    cout << "                                             'tiled' - The error is confined to each map. Faster with multiple threads" << endl;
+    cout << "                                             'tiled-seams' - Same as 'tiled', carrying the error from the borders of the previous maps" << endl;
     cout << "    -mn, --map-number [num]                Sets the last map ID or total number of maps in your world." << endl;
     cout << "                                           This applies only when --format is set to 'map'" << endl;
     cout << "    -bm, --build-method [method]           Sets the build method. By default '3d'" << endl;
@@ -166,6 +173,10 @@ int printHelp()
     cout << "    --minimize-support-blocks              Minimizes the support blocks, using them only when necessary" << endl;
     cout << "    -t, --threads [num]                    Specifies the number of threads to use." << endl;
     cout << "                                             By default all available cores will be used" << endl;
+    cout << "    --stats                                Prints statistics of the color search cache." << endl;
+    cout << "    --no-cache                             Disables the cache of palette lookup tables." << endl;
+    cout << "    --stream                               Processes the image one row of maps at a time." << endl;
+    cout << "                                             Uses less memory for big images, with the same result" << endl;
     cout << "    -y, --yes [num]                        Prevents asking any user input." << endl;
 
     cout << endl;
@@ -242,13 +253,13 @@ int renderMap(int argc, char **argv)
     std::vector<minecraft::FinalColor> colorSet = minecraft::loadFinalColors(baseColors);
 
     // Colors
-    std::vector<const minecraft::FinalColor *> colorsMatrix;
+    std::vector<map_color_t> colorsMatrix;
 
     // Load map file
     try
     {
-        std::vector<map_color_t> fileData = mapart::readMapNBTFile(argv[2]);
-        colorsMatrix = mapart::mapColorsToRGB(colorSet, fileData);
+        colorsMatrix = mapart::readMapNBTFile(argv[2]);
+        mapart::validateMapColors(colorSet, colorsMatrix);
     }
     catch (int code)
     {
@@ -290,9 +301,10 @@ int renderMap(int argc, char **argv)
     size_t j = 0;
     for (size_t i = 0; i < size; i++)
     {
-        colors::Color color = colorsMatrix[i]->color;
+        const minecraft::FinalColor &finalColor = colorSet[colorsMatrix[i]];
+        colors::Color color = finalColor.color;
 
-        if (colorsMatrix[i]->baseColorIndex == (short)minecraft::McColors::NONE)
+        if (finalColor.baseColorIndex == (short)minecraft::McColors::NONE)
         {
             alphaData[i] = 0;
         }
@@ -379,12 +391,16 @@ int buildMap(int argc, char **argv)
     int mapNumber = 0;
     ColorDistanceAlgorithm colorAlgo = ColorDistanceAlgorithm::Euclidean;
     DitheringMethod ditheringMethod = DitheringMethod::None;
+    ErrorDiffusionMode diffusionMode = ErrorDiffusionMode::Exact;
     MapBuildMethod buildMethod = MapBuildMethod::None;
     bool preserveTransparency = false;
     unsigned char transparencyTolerance = 128;
     int rsW = -1;
     int rsH = -1;
     bool yesForced = false;
+    bool printStats = false;
+    bool useCache = true;
+    bool streamMode = false;
     unsigned int threadNum = max((unsigned int)1, std::thread::hardware_concurrency());
     string materialsOutFile = "";
     Color background = {255, 255, 255};
@@ -612,7 +628,27 @@ int buildMap(int argc, char **argv)
                 if (ditheringMethod == DitheringMethod::Unknown)
                 {
                     std::cerr << "Unrecognized dithering: " << argv[i + 1] << endl;
-                    std::cerr << "Available dithering methods: none, floyd-steinberg, min-average-error, burkes, sierra-lite, stucki, atkinson, bayer-44, bayer-22, ordered-33" << endl;
+                    std::cerr << "Available dithering methods: none, floyd-steinberg, min-average-error, burkes, sierra-lite, stucki, atkinson, bayer-44, bayer-22, ordered-33, bayer-88, bayer-1616, blue-noise" << endl;
+                    return 1;
+                }
+                i++;
+            }
+            else
+            {
+                std::cerr << "Option " << arg << " requires a parameter." << endl;
+                std::cerr << "For help type: mcmap --help" << endl;
+                return 1;
+            }
+        }
+        else if (arg.compare(string("-dm")) == 0 || arg.compare(string("--diffusion-mode")) == 0)
+        {
+            if ((i + 1) < argc)
+            {
+                diffusionMode = parseErrorDiffusionModeFromString(string(argv[i + 1]));
+                if (diffusionMode == ErrorDiffusionMode::Unknown)
+                {
+                    std::cerr << "Unrecognized diffusion mode: " << argv[i + 1] << endl;
+                    std::cerr << "Available diffusion modes: exact, tiled, tiled-seams" << endl;
                     return 1;
                 }
                 i++;
@@ -699,6 +735,18 @@ int buildMap(int argc, char **argv)
         {
             yesForced = true;
         }
+        else if (arg.compare(string("--stats")) == 0)
+        {
+            printStats = true;
+        }
+        else if (arg.compare(string("--no-cache")) == 0)
+        {
+            useCache = false;
+        }
+        else if (arg.compare(string("--stream")) == 0)
+        {
+            streamMode = true;
+        }
         else if (arg.compare(string("--transparency")) == 0)
         {
             preserveTransparency = true;
@@ -769,6 +817,20 @@ int buildMap(int argc, char **argv)
         fs::create_directory(fs::path(outputPath));
     }
 
+    // Palette lookup tables cache
+    if (useCache)
+    {
+        std::string cacheDir = getCacheDir();
+
+        if (cacheDir.size() > 0)
+        {
+            setPaletteCacheFolder((fs::path(cacheDir) / fs::path("palettes")).string());
+        }
+    }
+
+    // Threads shared by all the stages
+    threading::initThreadPool(threadNum);
+
     // Initializae progress report thread
     threading::Progress p;
     thread progressReportThread(progressReporter, std::ref(p));
@@ -809,7 +871,17 @@ int buildMap(int argc, char **argv)
     p.startTask("Adjusting image size...", 0, 0);
     int matrixW;
     int matrixH;
-    mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(image, background, transparencyTolerance, &matrixW, &matrixH);
+    mapart::ImageColorMatrix originalImageColorMatrix;
+
+    if (streamMode)
+    {
+        // The rows are converted with each row of maps (see generateMapsRow)
+        getPaddedImageSize(image, &matrixW, &matrixH);
+    }
+    else
+    {
+        originalImageColorMatrix = loadColorMatrixFromImageAndPad(image, background, transparencyTolerance, &matrixW, &matrixH);
+    }
 
     // Load colors
     p.startTask("Loading minecraft colors...", 0, 0);
@@ -866,9 +938,29 @@ int buildMap(int argc, char **argv)
     applyBuildRestrictions(colorSet, buildMethod);
 
     // Generate map art
-    p.startTask("Adjusting image colors...", matrixH, threadNum);
     std::vector<size_t> countsMats(MAX_COLOR_GROUPS);
-    std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, matrixW, matrixH, preserveTransparency, colorAlgo, ditheringMethod, threadNum, p, countsMats);
+    mapart::PaletteMemoStats memoStats;
+
+    // Each map is stored contiguous, for the export
+    mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+    // Streaming mode: only the current row of maps is stored in mapArtTiles
+    mapart::MapArtStream stream;
+    mapart::ImageColorMatrix rowColorMatrix;
+    std::vector<map_color_t> rowMapArtColors;
+
+    if (streamMode)
+    {
+        p.startTask("Preparing color search...", 0, 0);
+        stream.init(colorSet, matrixW, matrixH, preserveTransparency, colorAlgo, ditheringMethod, diffusionMode, threadNum);
+    }
+    else
+    {
+        p.startTask("Adjusting image colors...", matrixH, threadNum);
+        std::vector<colors::Lab> labMatrix;
+        std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, labMatrix, originalImageColorMatrix.transparency, matrixW, matrixH, preserveTransparency, colorAlgo, ditheringMethod, diffusionMode, threadNum, p, countsMats, &memoStats);
+        mapArtTiles.load(mapArtColorMatrix, matrixW, matrixH);
+    }
 
     // Compute total maps
     int mapsCountX = matrixW / MAP_WIDTH;
@@ -878,14 +970,23 @@ int buildMap(int argc, char **argv)
     if (outFormat == MapOutputFormat::Map)
     {
         // No need to build, just export to nbt map files
-        p.startTask("Saving to map files...", mapsCountZ * mapsCountX, 1);
         int total = 0;
         for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
         {
+            if (streamMode)
+            {
+                generateMapsRow(stream, image, background, transparencyTolerance, mapZ, threadNum, rowColorMatrix, rowMapArtColors, mapArtTiles, p, countsMats);
+            }
+
+            int tilesZ = streamMode ? 0 : mapZ; // Row of the maps in mapArtTiles
+
+            p.startTask("Saving to map files...", mapsCountZ * mapsCountX, 1);
+            p.setProgress(0, total);
+
             for (int mapX = 0; mapX < mapsCountX; mapX++)
             {
                 // Get map data
-                std::vector<map_color_t> mapDataToSave = getMapDataFromColorMatrix(mapArtColorMatrix, matrixW, matrixH, mapX, mapZ);
+                std::vector<map_color_t> mapDataToSave = getMapDataFromColorMatrix(mapArtTiles, mapX, tilesZ);
 
                 // Save to file
                 stringstream ss;
@@ -921,30 +1022,41 @@ int buildMap(int argc, char **argv)
     }
     else if (outFormat == MapOutputFormat::StructureSingle)
     {
-        std::vector<std::vector<mapart::MapBuildingBlock>> chunks;
+        std::vector<mapart::MapBuildPlan> chunks;
 
-        p.startTask("Building maps...", 0, 0);
-        int total = 0;
         int totalMapsCount = mapsCountX * mapsCountZ;
-        for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
+
+        if (streamMode)
         {
-            for (int mapX = 0; mapX < mapsCountX; mapX++)
+            // Row by row, only the plans of the maps are kept
+            for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
             {
-                stringstream ss;
-                ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
-                p.startTask(ss.str(), MAP_WIDTH, threadNum);
-
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(version, blockSet, mapArtColorMatrix, matrixW, matrixH, mapX, mapZ, buildMethod, threadNum, p);
+                generateMapsRow(stream, image, background, transparencyTolerance, mapZ, threadNum, rowColorMatrix, rowMapArtColors, mapArtTiles, p, countsMats);
 
-                // Add to materials list
-                materials.addBlocks(buildingBlocks);
+                p.startTask("Building maps...", static_cast<unsigned int>(mapsCountX * MAP_WIDTH), threadNum);
 
-                // Add chunk
-                chunks.push_back(buildingBlocks);
+                std::vector<mapart::MapBuildPlan> rowChunks;
+                mapart::buildMaps(version, blockSet, colorSet, mapArtTiles, buildMethod, threadNum, p, rowChunks);
 
-                total++;
+                for (size_t i = 0; i < rowChunks.size(); i++)
+                {
+                    chunks.push_back(std::move(rowChunks[i]));
+                }
             }
         }
+        else
+        {
+            p.startTask("Building maps...", static_cast<unsigned int>(totalMapsCount * MAP_WIDTH), threadNum);
+
+            // All the maps at once, in parallel
+            mapart::buildMaps(version, blockSet, colorSet, mapArtTiles, buildMethod, threadNum, p, chunks);
+        }
+
+        // Add to materials list
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            materials.addBlocks(chunks[i]);
+        }
 
         p.startTask("Building maps...", static_cast<unsigned int>(totalMapsCount), 1);
 
@@ -981,30 +1093,41 @@ int buildMap(int argc, char **argv)
     }
     else if (outFormat == MapOutputFormat::SchematicSingle)
     {
-        std::vector<std::vector<mapart::MapBuildingBlock>> chunks;
+        std::vector<mapart::MapBuildPlan> chunks;
 
-        p.startTask("Building maps...", 0, 0);
-        int total = 0;
         int totalMapsCount = mapsCountX * mapsCountZ;
-        for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
+
+        if (streamMode)
         {
-            for (int mapX = 0; mapX < mapsCountX; mapX++)
+            // Row by row, only the plans of the maps are kept
+            for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
             {
-                stringstream ss;
-                ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
-                p.startTask(ss.str(), MAP_WIDTH, threadNum);
+                generateMapsRow(stream, image, background, transparencyTolerance, mapZ, threadNum, rowColorMatrix, rowMapArtColors, mapArtTiles, p, countsMats);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(version, blockSet, mapArtColorMatrix, matrixW, matrixH, mapX, mapZ, buildMethod, threadNum, p);
-
-                // Add to materials list
-                materials.addBlocks(buildingBlocks);
+                p.startTask("Building maps...", static_cast<unsigned int>(mapsCountX * MAP_WIDTH), threadNum);
 
-                // Add chunk
-                chunks.push_back(buildingBlocks);
+                std::vector<mapart::MapBuildPlan> rowChunks;
+                mapart::buildMaps(version, blockSet, colorSet, mapArtTiles, buildMethod, threadNum, p, rowChunks);
 
-                total++;
+                for (size_t i = 0; i < rowChunks.size(); i++)
+                {
+                    chunks.push_back(std::move(rowChunks[i]));
+                }
             }
         }
+        else
+        {
+            p.startTask("Building maps...", static_cast<unsigned int>(totalMapsCount * MAP_WIDTH), threadNum);
+
+            // All the maps at once, in parallel
+            mapart::buildMaps(version, blockSet, colorSet, mapArtTiles, buildMethod, threadNum, p, chunks);
+        }
+
+        // Add to materials list
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            materials.addBlocks(chunks[i]);
+        }
 
         p.startTask("Building maps...", static_cast<unsigned int>(totalMapsCount), 1);
 
@@ -1046,13 +1169,20 @@ int buildMap(int argc, char **argv)
         int totalMapsCount = mapsCountX * mapsCountZ;
         for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
         {
+            if (streamMode)
+            {
+                generateMapsRow(stream, image, background, transparencyTolerance, mapZ, threadNum, rowColorMatrix, rowMapArtColors, mapArtTiles, p, countsMats);
+            }
+
+            int tilesZ = streamMode ? 0 : mapZ; // Row of the maps in mapArtTiles
+
             for (int mapX = 0; mapX < mapsCountX; mapX++)
             {
                 stringstream ss;
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 p.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(version, blockSet, mapArtColorMatrix, matrixW, matrixH, mapX, mapZ, buildMethod, threadNum, p);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(version, blockSet, colorSet, mapArtTiles, mapX, tilesZ, buildMethod, threadNum, p);
 
                 // Add to materials list
                 materials.addBlocks(buildingBlocks);
@@ -1069,7 +1199,7 @@ int buildMap(int argc, char **argv)
 
                     try
                     {
-                        writeStructureNBTFile(outFilePath.string(), buildingBlocks, supportBlockOptions, version, false);
+                        writeStructureNBTFile(outFilePath.string(), buildingBlocks, supportBlockOptions, version, false, p.getCancellationToken());
                     }
                     catch (...)
                     {
@@ -1091,7 +1221,7 @@ int buildMap(int argc, char **argv)
 
                     try
                     {
-                        writeSchematicNBTFile(outFilePath.string(), buildingBlocks, supportBlockOptions, version, false);
+                        writeSchematicNBTFile(outFilePath.string(), buildingBlocks, supportBlockOptions, version, false, p.getCancellationToken());
                     }
                     catch (...)
                     {
@@ -1113,7 +1243,7 @@ int buildMap(int argc, char **argv)
 
                     try
                     {
-                        writeMcFunctionFile(outFilePath.string(), buildingBlocks, version);
+                        writeMcFunctionFile(outFilePath.string(), buildingBlocks, version, p.getCancellationToken());
                     }
                     catch (...)
                     {
@@ -1170,9 +1300,49 @@ int buildMap(int argc, char **argv)
         }
     }
 
+    if (printStats)
+    {
+        if (streamMode)
+        {
+            memoStats = stream.getMemoStats();
+        }
+
+        if (memoStats.lookups > 0)
+        {
+            std::cerr << "Color search cache: " << memoStats.hits << " hits of " << memoStats.lookups << " searches ("
+                      << (100.0 * memoStats.hits / memoStats.lookups) << "%), " << memoStats.entries << " colors stored" << endl;
+        }
+        else
+        {
+            std::cerr << "Color search cache: not used (lookup table)" << endl;
+        }
+    }
+
     return 0;
 }
 
+void generateMapsRow(mapart::MapArtStream &stream, wxImage &image, colors::Color background, unsigned char transparencyTolerance, int mapZ, unsigned int threadNum, mapart::ImageColorMatrix &rowColorMatrix, std::vector<map_color_t> &rowColors, mapart::TiledMatrix<map_color_t> &rowTiles, threading::Progress &p, std::vector<size_t> &counts)
+{
+    int matrixW;
+    int matrixH;
+    getPaddedImageSize(image, &matrixW, &matrixH);
+
+    size_t fromZ = static_cast<size_t>(mapZ) * MAP_HEIGHT;
+    size_t toZ = fromZ + MAP_HEIGHT;
+    size_t matrixZ = fromZ - min(fromZ, stream.getContextRows()); // Rows above, for the seams
+
+    stringstream ss;
+    ss << "Adjusting image colors (" << (mapZ + 1) << "/" << (matrixH / MAP_HEIGHT) << ")...";
+    p.startTask(ss.str(), MAP_HEIGHT, threadNum);
+
+    loadColorMatrixRowsFromImage(image, background, transparencyTolerance, static_cast<int>(matrixZ), static_cast<int>(toZ), rowColorMatrix);
+
+    rowColors.resize(static_cast<size_t>(matrixW) * MAP_HEIGHT);
+    stream.generateRows(rowColorMatrix.colors.data(), rowColorMatrix.transparency, matrixZ, fromZ, toZ, p, rowColors.data(), counts);
+
+    rowTiles.load(rowColors, matrixW, MAP_HEIGHT);
+}
+
 void progressReporter(threading::Progress &progress)
 {
     bool ended = false;
@@ -37,6 +37,7 @@
 #include "mapart/map_art.h"
 #include "mapart/map_image.h"
 #include "threads/progress.h"
+#include "threads/thread_pool.h"
 #include "minecraft/structure.h"
 #include "minecraft/schematic.h"
 #include "minecraft/mcfunction.h"
@@ -51,6 +52,25 @@ int buildMap(int argc, char ** argv);
 int fixMaps(int argc, char ** argv);
 void progressReporter(threading::Progress &progress);
 
+/**
+ * @brief  Generates a row of maps (streaming mode)
+ * @note   Converts only the rows of the image needed by the row of maps.
+ *         Rows must be generated in order (see mapart::MapArtStream)
+ * @param  &stream: Generation of the map art
+ * @param  &image: Image
+ * @param  background: Background color
+ * @param  transparencyTolerance: Transparency tolerance
+ * @param  mapZ: Row of maps
+ * @param  threadNum: Number of threads
+ * @param  &rowColorMatrix: Colors of the rows (memory reused by the next rows)
+ * @param  &rowColors: Map colors of the rows (memory reused by the next rows)
+ * @param  &rowTiles: Matrix to store the maps of the row
+ * @param  &p: Progress
+ * @param  &counts: Counts of each color, the counts of the row are added
+ * @retval None
+ */
+void generateMapsRow(mapart::MapArtStream &stream, wxImage &image, colors::Color background, unsigned char transparencyTolerance, int mapZ, unsigned int threadNum, mapart::ImageColorMatrix &rowColorMatrix, std::vector<map_color_t> &rowColors, mapart::TiledMatrix<map_color_t> &rowTiles, threading::Progress &p, std::vector<size_t> &counts);
+
 enum class MapOutputFormat {
     Map,
     Structure,
@@ -24,6 +24,9 @@
 #include "main_win.h"
 #include "wx/img_display_window.h"
 #include "wx/main_window.h"
+#include "mapart/palette_cache.h"
+#include "tools/basedir.h"
+#include "tools/fs.h"
 #include <wx/msgdlg.h>
 
 using namespace std;
@@ -36,6 +39,14 @@ wxIMPLEMENT_APP(App);
 
 bool App::OnInit()
 {
+    // Palette lookup tables cache
+    std::string cacheDir = tools::getCacheDir();
+
+    if (cacheDir.size() > 0)
+    {
+        mapart::setPaletteCacheFolder((fs::path(cacheDir) / fs::path("palettes")).string());
+    }
+
     if (mainEntryPoint(*this, this->argc, this->argv) != 0) {
         this->Exit();
     }
@@ -63,9 +74,9 @@ int mainEntryPoint(App &app, int argc, char *argv[])
     try
     {
         std::vector<map_color_t> fileData = mapart::readMapNBTFile(argv[1]);
-        std::vector<const minecraft::FinalColor *> colorMatrix = mapart::mapColorsToRGB(colorSet, fileData);
+        mapart::validateMapColors(colorSet, fileData);
 
-        widgets::displayMapImage(colorMatrix, app);
+        widgets::displayMapImage(fileData, colorSet, app);
     }
     catch (int)
     {
@@ -0,0 +1,293 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+// Size of the blue noise texture
+#define BLUE_NOISE_SIZE (64)
+
+namespace mapart
+{
+    /*
+     * Tileable blue noise texture, generated with the void-and-cluster method (sigma = 1.5).
+     * Each value is the rank of the pixel, from 1 to (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE),
+     * so any threshold selects evenly spread pixels.
+     */
+    constexpr unsigned short BLUE_NOISE_RANKS[BLUE_NOISE_SIZE][BLUE_NOISE_SIZE] = {
+        { 733, 2317,  941, 3423,  560, 2686,  295, 2872, 2398,  152, 1554, 3588,  283, 1858, 3877, 3363,
+         1676, 2808, 3579, 2554,   27,  952, 2889,  307, 1736, 2312, 1098,  687, 1857, 1346, 3981, 2340,
+         1753, 3475, 1425, 3157, 3799, 1269, 3378,  113, 3866, 2378,  496, 2892, 1891,    1, 1423, 2472,
+         3436,  392, 3766, 2225,  531, 1815, 3511, 1204, 3085, 2024,  620, 1177, 2777, 1946, 3388, 2642},
+        {1806, 3737, 1319, 2146, 3860, 1142, 1949, 3647, 1011, 4051, 2066,  576, 3182, 1121, 2621,  613,
+         3063,  221, 1219, 2084, 3162, 1569, 3437, 1282, 4096, 2753, 3135, 3580, 2486, 3069,    8, 1180,
+         2871,  653, 2425, 1826,  362, 2207,  640, 2978, 1470,  838, 3253, 4062,  945, 3539, 3082, 2002,
+          722, 1321, 1646, 3030,  949, 2543,   55, 2343, 3921,  298, 3692, 1766, 3208, 1367, 3825,  460},
+        {3170,  238, 2865, 1689,  159, 3238, 2310,  585, 1720, 3338, 2593,  878, 3699, 2309,  111, 2058,
+         1036, 4049, 1823,  649, 3815, 2350,  563, 2148,  899,  454, 2000,  227,  910, 1607, 3685, 2187,
+         3293,  253, 4011,  854, 3623, 2765, 1637, 3690, 2567, 2013,  218, 1391, 2265,  635, 2643,  312,
+         4022, 3236, 2695,  250, 3872, 3249, 1513,  650, 1869, 2836,  936, 2535,   15, 2211,  865, 2400},
+        {1476, 3558,  616, 2461, 3003,  821, 3522, 1410, 2980,  399, 1312, 2929, 1772, 1403, 2860, 3756,
+         1528, 2402, 3476, 2691,  287, 1117, 2807, 3754, 1635, 3248, 1419, 3925, 2304, 3382,  492,  797,
+         1552, 2693, 2056, 1365, 3081, 1024, 2083,  324, 1190, 3556, 2698, 3371, 1752, 3836, 1130, 1615,
+         2159,  900, 2357, 1859, 1281, 2087, 3666, 2656, 1139, 3548, 1477, 3300,  699, 3487, 2896, 1132},
+        {1964, 2657,  991, 4041, 1241, 1824, 2586,   36, 3879, 1985, 2366,  230, 3980,  505, 3400,  716,
+         3218,  386,  882, 1445, 3302, 1755, 3108,  146, 2532, 3610,  748, 2902, 1210, 2659, 1829, 2957,
+         3733, 1000, 3405,  490, 2504,   35, 3288, 3853,  667, 1791, 1001,  511, 2419,  193, 3201, 2826,
+         3478,  148, 3751,  607, 2958,  315,  872, 3018,  150, 2237,  455, 1954, 3878, 1575,  274, 3977},
+        {3346,  360, 2231, 1541, 3277,  434, 3739, 2172, 1133,  713, 3494, 3062,  976, 2527, 1837, 1194,
+         2661, 1920, 3008, 2267, 3927,  745, 2022, 1336,  403, 2210, 1746,  535, 2085,  118, 4055, 1304,
+         1971,  141, 2346, 1507, 3525, 1874, 1299, 2853, 2197, 3151, 3982, 2950, 1337, 3687, 1884,  550,
+         1233, 1556, 3099, 1021, 2493, 3965, 1660, 3403, 1361, 4036, 3087, 2716,  957, 2131, 2509,  663},
+        {1224, 3034, 3621,  181, 2049,  771, 2857, 1593, 3222, 2633, 1682, 1245, 2103, 3581,    5, 2253,
+         3890,  251, 3603, 1256,   58, 2568, 3463, 4023, 2787, 1083, 3050, 3829, 3457,  963, 3241,  416,
+         2523, 3102, 3830,  651, 2721, 4086,  820, 2409,  393, 1526,   63, 2099,  685, 2630,  928, 2337,
+         3894, 2580, 1926, 3551, 1439, 2227,  545, 2011, 2561,  773, 1683, 1198,  121, 3145, 3747, 1712},
+        {2319,  848, 1832, 2773, 3822, 2325, 3438,  974,  489, 3938,  139, 3714,  592, 2783, 1546, 3155,
+         1049, 1643,  636, 2078, 2914, 1072,  513, 1613,  800, 3336, 2473,  331, 1378, 2373, 1662, 2828,
+          744, 1229, 1732, 2202, 1108,  198, 1634, 3209, 3696, 1150, 2545, 3789, 1730, 3044, 3550,   94,
+         3216,  766,  414, 2811,   25, 3278, 2905, 1056, 3677,  223, 3435, 2428, 3633, 1400,  449, 2809},
+        {  44, 3904, 1334,  522, 1046, 1446,  151, 1915, 2997, 1411, 2316, 1843, 3242,  894, 4084,  423,
+         2887, 3370, 2602, 3862, 1776, 3263, 2418, 1951, 3783,   70, 1522, 1983, 2771,  562, 3560, 2055,
+         3923, 3286,  265, 3578, 2900, 3335, 2060,  605, 2708, 1903,  849, 3364,  339, 1088, 1560, 2017,
+         1339, 2212, 4079, 1739,  837, 1279, 3851,  383, 1848, 2970, 2082,  552, 2864, 1938,  801, 3514},
+        {2100, 3220, 2505, 3526, 3094, 2674, 4059, 2434, 3540,  764, 2874,  398, 2552, 1442, 2389, 1980,
+          798, 2200, 1356,  340,  832, 3673,  208, 3142, 1154, 2181, 3629,  853, 3994, 3132, 1110,   41,
+         1455, 2362,  983, 1923,  480, 2485, 1330, 3936,  239, 3572, 2897, 1375, 2208, 4028, 2796,  382,
+         3720, 2936, 1079, 2421, 3651, 2090, 2631, 1559, 2390,  884, 3912, 1521, 1039, 4092, 2536, 1497},
+        {2856,  657, 1686,  278, 2007,  706, 1715,  431, 1186, 2042, 3351, 1066, 3779,  182, 3448, 1238,
+         3761,  164, 3532, 3016, 1563, 2273, 1309, 2821,  619, 2565, 3000, 1260,  254, 2289, 1620, 3703,
+         2734,  587, 3037, 3979, 1571, 3676,  940, 2284, 1761,  704, 2376,  131, 3194,  579, 2479, 3456,
+          703, 1629,  183, 3396, 2870,  297,  697, 3409, 3076, 1329,  358, 3296, 2234,  173, 3180,  995},
+        { 237, 4009, 1196, 2384, 3802, 1305, 3175, 3653, 2786,   49, 3998, 1728, 2141, 2964,  661, 2776,
+         1709, 2364, 1032, 1955, 4038,  435, 3452, 1747, 3896,  350, 1639, 3468, 1911,  622, 2612,  889,
+         3394, 2027, 1287, 2587,  759,   52, 2840, 3460, 1174, 3113, 1600, 3679, 1940,  912, 1741, 1244,
+         2332, 3245, 2048,  606, 1461, 1894, 4012, 1100,  158, 3784, 2590, 1830, 2954,  631, 3757, 1889},
+        {3541, 2039, 3354,  896, 2976,  133, 2246,  972, 1625, 2411, 1355,  469, 3203,  930, 1931, 3968,
+          529, 3252, 2647,  666, 2854, 1111, 2470,  903, 2065, 3305,  755, 2449, 2893, 3775, 3186, 1864,
+          430, 3826,  178, 3470, 1810, 3133, 2012,  334, 2530, 3892,  465, 1074, 2636, 3835, 2952,   40,
+         3964,  958, 2626, 3818, 1158, 3134, 2296, 2746, 1749, 2177,  774, 3615, 1165, 1649, 2432, 1352},
+        { 767, 2668,  317, 1544, 2539, 1817, 3426,  595, 3813, 3121,  836, 2684, 3680, 1586, 2501,   69,
+         1392, 3608, 1612,  112, 2139, 3228, 3769,  149, 2743, 1385, 4085,   62,  982, 1434,  224, 1201,
+         2463, 1525, 2920,  925, 2391, 1318, 4029, 1532,  869, 2101, 2934, 3434, 1417,  292, 3324, 1999,
+         1489, 3049,  313, 1717, 3474,   60,  843, 3672,  517, 3443, 1449,    4, 2689, 3383,  447, 3055},
+        {2271, 1726, 3149, 3642,  481, 3931, 1090, 2649,  220, 1867, 3543, 2255,  245, 1167, 3369, 2922,
+         2229,  818, 3054, 3837, 1345, 1816,  711, 1585, 3143, 1091, 2238, 1788, 3519, 2153, 3922, 2803,
+         3304,  556, 2143, 3658,  365, 3271,  590, 2754, 3328,   89, 1847,  742, 2431, 2161,  852, 2780,
+          546, 3656, 2214,  751, 2815, 2454, 1545, 2064, 1232, 2833, 2348, 3996,  893, 2086, 3916, 1063},
+        {  78, 3812,  655, 1259, 2168, 2861, 1468, 2071, 3013, 1143,  537, 1529, 3915, 2112,  617, 3740,
+         1113, 1945,  310, 2285, 3413,  395, 2926, 2331, 3630,  291, 2667, 3257,  528, 2551,  730, 1952,
+         1010, 4060, 1661, 1239, 2694, 1892, 1077, 2298, 3786, 1300, 2664, 4045,  440, 3723, 1611, 3546,
+         1092, 2489, 1360, 4054, 1933,  391, 3833, 3283,  225, 3153,  588, 1927, 3109,  337, 1396, 2842},
+        {3344, 1437, 2417, 3002,  877,   18, 3387,  768, 4075, 2383, 3360, 2879,  807, 3150, 1790,  366,
+         2598, 4067, 2817, 1183,  883, 2582, 4010,  994, 1913,  638, 3793, 1537, 1223, 3097, 1687, 3563,
+           14, 2338, 3080,  736, 3847,  116, 3534, 1644,  371, 3057,  966, 1703, 3198, 1184, 2601,  126,
+         1834, 2993,  233, 3214, 1053, 2945, 1325, 2611,  980, 1692, 3731, 1124, 1568, 2618, 3689, 1895},
+        {2521,  443, 1992, 3978, 1688, 3617, 2452, 1742,  301, 1382, 1974,  192, 2442, 1278, 2758, 3499,
+         1493,  642, 1695, 3128, 3670, 1988,   38, 1450, 3355, 2967,  915, 2132,  140, 3674,  439, 2979,
+         1430, 2763,  293, 3366, 2067, 2437, 2943,  812, 1987, 3447, 2250,  202, 2882,  627, 2096, 3256,
+         3945,  813, 2156, 1606,  568, 3592, 2221,  678, 4027, 2037, 2502,  412, 3574, 2199,  242,  879},
+        {3869, 1103, 3410,  279, 2692, 1214,  521, 3140, 2810, 3764,  975, 3638, 1648, 3999,   30,  917,
+         2324, 3303,  188, 2435,  515, 1580, 3531, 2218,  453, 2506, 1771, 3975, 2713, 2326, 1123, 2072,
+          898, 3728, 1789, 1052, 1503,  507, 1255, 3957, 2585,  641, 1397, 3613, 1883, 3870, 1408,  378,
+         2731, 1257, 3776, 3339, 2677, 1798,  285, 3377, 1478,   64, 2991, 3356,  777, 2875, 1290, 3202},
+        {1841, 2886,  723, 1512, 3247, 2286, 3888, 1047, 2150,  645, 2615, 3064,  457, 2167, 3223, 1885,
+         3861, 1292, 2106, 3796,  810, 2767, 3078, 1089, 3745, 1357,  266, 3164,  738, 1490, 3887, 3200,
+         2605,  637, 2276, 4008, 2563, 3637, 3159, 1595,   28, 3770, 2779, 1104, 2474,  860, 3482, 2275,
+         1708,  539, 2514,   23,  920, 3909, 1250, 2869, 2447, 3655,  959, 1402, 1875, 4074,  554, 1579},
+        { 100, 2347, 3598, 2080,  918,  136, 1918, 1458, 3414,   83, 1831, 1120, 3467,  743, 1203, 2730,
+          290, 3024,  984, 3401, 1902, 1310,  234, 2363,  673, 2910, 3508, 1070, 1986, 3415,  582,  115,
+         1617, 3345,  384, 2904,  842,  252, 1880, 1014, 2342, 3117, 1678,  418, 3276,   72, 2822, 1061,
+         3172, 3654, 1975, 1342, 2353, 3106, 2116,  850, 1825,  369, 2241, 2752,  154, 2397, 3459, 2673},
+        {3129, 1189,  508, 4042, 2583, 3033, 3695,  780, 2711, 4026, 2354, 1550, 2868, 2497, 1614, 3646,
+          679, 2570, 1721,   81, 2487, 3873, 3270, 1740, 4047, 1567, 2171, 2566,  189, 2873, 1805, 2359,
+         3804, 1234, 2001, 1444, 3269, 2134, 2740, 3425,  346, 2005,  770, 4093, 2216, 1483, 1944, 3959,
+          244,  789, 2956, 3503, 1693,  623,  200, 3798, 3183, 1185, 3951, 1603, 3067, 1065, 2059,  763},
+        {3906, 1959, 3314, 1744, 1343,  396, 2406, 1657,  462, 3177,  876, 3576,  166, 3963,  348, 2204,
+         3309, 1386, 3958, 2877,  548,  946, 2070,  374, 2696,  868,  502, 3645, 1409, 4004, 1144, 3052,
+          924, 2766, 3538,   59, 3857, 1169,  610, 3989, 1370, 3552, 2557, 1240, 2989, 3698,  583, 2401,
+         1598, 2616, 1037,  357, 4071, 2741, 3424, 1463, 2540,  495, 3367,  698, 3606,  456, 3736, 1399},
+        { 332, 2526,  992,  171, 2814, 3453, 1081, 3282, 1981, 1247, 2142,  599, 1394, 1967, 2994, 1025,
+         1828,  424, 2262, 1187, 3528, 1482, 3014, 3612, 1222, 3321, 1854, 2769,  408, 2245,  672, 3590,
+          243, 2169,  739, 1690, 2387, 2968, 1762, 2513,  919, 2912,  506, 1870,  216,  967, 3375, 1272,
+         3126, 3782, 2185, 1519, 2480, 1156, 1914,  758, 2988, 2109, 1750, 2579, 1253, 2302, 1780, 2855},
+        {3440, 1467, 3075, 2256, 3824,  577, 2126, 3926,  281, 2998, 2564, 3753, 3206, 2404,  752, 3819,
+         2793, 3664,  826, 3188, 1973, 2663,  718, 2423,    2, 2209, 3883, 1041, 1723, 3280, 2628, 1929,
+         1511, 4064, 2653, 3169,  961,  411, 3347,  102, 2224, 1583, 3908, 3251, 2629, 1658, 2784,  401,
+         1989,  125, 3406,  684, 3207,   82, 2279, 3570,  296, 1080, 3821,  214, 2930, 3317,   16,  914},
+        {2108,  466, 3634,  794, 1909, 1516, 2641,  762, 1427, 3520,   12, 1664, 1136,  448, 3445, 1510,
+          226, 2496, 1669,  114, 4021,  342, 1787, 3803, 1436, 3165,  691, 2973, 3694,   68, 1322, 2999,
+          538, 3333,  289, 1338, 3787, 2092, 1452, 3827, 3066,  294, 1048, 2123,  715, 3496, 2252, 4034,
+          845, 2891, 1191, 1882, 3746, 2797,  955, 3997, 1576, 2433, 3285,  833, 1943, 1498, 4044, 2701},
+        {3795, 1674, 2436, 1277, 3233,   96, 3559, 2937, 2394, 1878,  938, 2806, 3875, 1888, 2650, 1206,
+         2050, 3407, 1125, 2966, 2360, 1324, 3231,  973, 1995, 2610,  273, 1547, 2035,  886, 3948, 2424,
+         1075, 1770, 2490, 1969,  598, 3518, 2795,  805, 1850, 3595, 2476, 1429, 3808,   11, 1115, 1462,
+         2515, 1696, 3905, 2330,  510, 1395, 1795, 3148,  639, 2866, 1374, 2232, 3678,  614, 2430, 1200},
+        { 720, 3009,  222, 2728, 4088,  969, 1719,  336, 1161, 4018, 3160,  659, 2292,  335, 3120, 4078,
+          712, 2845,  471, 1899, 3749,  643, 2717, 3454,  467, 4070, 1289, 2327, 2712, 3380,  426, 2094,
+         3659,  761, 3489, 3019, 1160, 2403,  269, 1268, 2682,  571, 3381,  367, 2938, 1839, 3084, 3593,
+          584, 3259,  195,  981, 3007, 3513,  267, 2542, 2021,   56, 3929,  406, 1138, 3166,  257, 1982},
+        {3379, 1106, 3707,  658, 1961, 2329, 3144, 3652, 2162,  459, 2522, 1472, 3554,  996, 1679,   76,
+         2264, 3704, 1592, 3484,  986, 2230,  176, 1680, 2939,  809, 3498, 3107,  581, 1162, 1594, 3130,
+          194, 2737, 1495,   31, 3988, 1701, 3240, 2178, 3962, 1631, 2023, 1084, 2592,  746, 2160,  261,
+         2813, 2026, 3640, 1553, 2645, 2093,  781, 3722, 1211, 3461, 1822, 3039, 2550, 3567, 1581, 2775},
+        { 417, 1809, 2240, 1432, 2944,  476, 1249, 2681,  867, 1751, 3349,  142, 2016, 2942, 2547, 3322,
+         1415,  847, 2559,  300, 3217, 1524, 3952, 2455, 1193, 2145, 1774,  105, 3914, 1922, 3708, 2622,
+         1315, 3902, 2258,  881, 2851,  542,  988, 3469,   71,  866, 3204, 3874, 1514, 3297, 3985, 1671,
+         1235,  772, 2439,  444, 3947, 1155, 3237, 1642, 2798,  902, 2356, 1453,  688, 2057,  954, 3991},
+        {1320, 3096, 2619,  134, 3343, 3742, 1584,   57, 3838, 2947, 1263, 3727,  790, 3956, 1163,  547,
+         3828, 2032, 3029, 1213, 2114, 2876,  787, 3521,  270, 3724, 2553, 1004, 2859, 2233,  272,  916,
+         1865,  569, 3197, 2051, 3564, 2462, 1907, 2940, 1377, 2244, 2825,  165, 2358,  503,  979, 2482,
+         3691, 3185, 1347, 3365, 1836,  130, 2308,  359, 4037,  524, 3348,  229, 3893, 2884,   79, 2465},
+        {3693,  792, 3942, 1040, 1758,  719, 2413, 3219, 1966,  626, 2287, 2722, 1605,  306, 2380, 1781,
+         2816,  228, 3537,  680, 3854,   51, 1353, 1905, 3091,  624, 1558, 3318, 1407,  721, 3458, 3072,
+         2377, 3591, 1114, 1596,  304, 1332, 3777,  381, 2534, 3527,  611, 1890, 1181, 3500, 2839,  397,
+         1879,   53, 2149, 2863,  908, 3778, 3032, 1328, 2495, 2028, 1684, 2655, 1226, 1748, 3301, 2175},
+        {1604,  349, 1991, 3451, 2760, 2155, 4007, 1059, 1435, 3472,  210, 1027, 3095, 2128, 3510, 3244,
+          933, 1364, 1852, 2445, 1616, 2635, 3340, 2288, 1062, 2756, 3983,  379, 2355, 3805, 1621, 1195,
+          413, 2881,  124, 4083, 2723, 3310,  669, 1733, 4003, 1044, 1609, 3750, 3122, 2074, 1465, 3856,
+         3065,  993, 4089,  589, 1508, 2634, 1916,  618, 3569,  989, 3790, 3022,  824, 3648,  504, 1055},
+        {3505, 2969, 2488,  557, 1266,  175, 2995,  388, 2841, 2533, 3941, 1835, 3631,  696, 1306,   24,
+         2660, 4033, 3176,  402, 3609,  950,  567, 3881,  309, 1764, 2117,  873, 2962,   17, 2671, 2133,
+         3859, 1722, 2584, 1996,  827, 2263, 1207, 3158, 2121,  204, 2948, 2407,  831,  256, 2652,  726,
+         2243, 1656, 3492, 2464,  311, 3624, 1043, 3274, 2862,  187, 1406,  437, 2291, 1947, 3104, 2609},
+        {1804,    7, 1447, 3849, 3184, 1626,  839, 3600, 1699,  555, 2173, 1359,  421, 2831, 3911, 1698,
+         2165,  735, 2306, 1116, 3005, 2061, 2785, 1487, 2475, 3432, 3137, 1293, 3577, 1873,  609, 3199,
+          932, 3368,  574, 1426, 3486, 2906,   85, 2600,  802, 3392, 1316,  464, 4050, 1737, 3566, 1326,
+          201, 2794, 1208, 2003, 3139, 1765,  103, 2261, 1540, 2104, 3398, 2562, 4076,  143, 1350,  710},
+        {2124, 3607,  968, 2341, 1957, 3725, 2468, 2062, 1205, 3376,  887, 3189, 2460, 1978, 1006, 3070,
+          494, 3427, 1565,  240, 3960, 1718,  109, 3555, 1157,  724,  219, 1652, 2458, 1058, 4025, 1486,
+          286, 2334, 1146, 3797,  345, 1801, 3933, 1494, 3639, 1833, 2697, 2054, 3254, 1096, 3038, 2368,
+         3785, 3341,  452,  835, 3858, 1348, 2739, 4016,  816, 3721,  565, 1710, 1131, 3353, 2838, 3928},
+        {1168, 3123, 2709,  686,  368, 1118, 3267,  263, 4053, 2606,   84, 3840, 1534,  205, 3604, 2529,
+         1275, 3755, 2913, 2595, 1317, 3298,  840, 2921, 2184, 4077, 2632, 3713,  461, 3299, 2742, 2030,
+         3031, 3628, 2801, 2127, 3116, 1012, 2215,  543, 2992,  277, 3882,  906, 2525,   75, 1919,  520,
+          956, 1509, 2546, 2965, 2220,  608, 3311,  450, 2484, 1218, 2812, 3193,  757, 2190, 1564,  468},
+        {2382,  213, 1694, 3990, 2975, 1520, 2738,  729, 1819, 3056, 2277, 1099, 2789, 3275,  785, 2111,
+          316, 1807,  923, 2018,  647, 2295, 3801, 1778,  438, 1551, 3046, 1968,  859, 2235,  155, 1273,
+          760, 1792,   48, 1515,  692, 2556, 3562, 1296, 2426, 1064, 1647,  566, 3504, 1533, 3719, 2901,
+         2120, 4024, 1840,   45, 3662, 1086, 2014, 1574, 3086, 1845,   34, 2367, 3667,  276, 2658, 3408},
+        { 885, 3780, 1285, 2105, 3455,   61, 2259, 3571, 1323,  343, 1602, 3686,  473, 1863, 1383, 4091,
+         2702, 3294,  161, 3880, 3053,  364, 1199, 2569, 3229, 1017,   66, 1373, 2837, 3919, 1665, 3393,
+         3811, 2614, 1054, 3995, 3359, 1729,  190, 3171, 2020, 3735, 2782, 3124, 2228, 1192, 2665,  778,
+         3191,  318, 1164, 3258, 1633, 2700, 3907,  232, 3485,  891, 3970, 1456, 1939, 1023, 3864, 1872},
+        {3243, 2849,  427, 2608,  741, 1851, 3855,  999, 2880, 3325, 2036,  828, 2416, 3512, 2924,  559,
+         1087, 2388, 1418, 3483, 1651, 2735, 3683,  612, 2073, 3903, 2408, 3616,  527, 1095, 2451,  338,
+         2189,  549, 2987, 2314,  404, 2705,  948, 4061,  740,   19, 1313, 1901,  385, 4001,  184, 1731,
+         1349, 2591, 3553, 2374,  419,  856, 2270, 1298, 2599, 2113, 2986,  487, 3465, 3060, 1366,  603},
+        {1471, 2009, 3661,  985, 3136, 1372, 2548,  441, 2203,  670, 3885, 2710, 1237,  236, 2182, 1691,
+         3788, 3012,  775, 2195,  997,    9, 1912, 1390, 3464,  303, 1745, 3090, 2115, 3473, 2927,  888,
+         3221, 1599, 3709, 1254, 1861, 3605, 1433, 2883, 1700, 2576, 3261, 3626,  799, 3028, 2395, 3433,
+         3792,  671, 1935, 1018, 2846, 3596, 3190,  707, 3743,  328, 1166, 2736,  782, 2516,  196, 2299},
+        {3517,   91, 1724, 2318, 4082,  199, 3390, 1714, 3636, 1451,   26, 1779, 3103, 3939,  863, 3327,
+          107, 1921,  483, 2850, 3950, 2427, 3331, 2974,  870, 2770, 1170,  662, 1531,  137, 1871, 3889,
+         1358, 2044,  128,  795, 3163, 2152,  268, 2328, 3449,  500, 1009, 2320, 1473, 1849, 1085,  486,
+         2140, 2919,  163, 3973, 1413, 1796,   86, 1962, 1488, 3281, 1794, 3705, 2154, 1627, 4039, 2725},
+        { 754, 3088, 1230,  499, 2818, 1998, 1149, 2724,  864, 2996, 2457, 3441,  530, 1570, 2577, 1331,
+         2344, 3669, 1548, 3230, 1261,  693, 1589,  420, 2179, 3763, 2500, 3308, 3987, 2683, 1217,  601,
+         2572, 3523, 2903, 2483, 3917, 1097,  632, 3814, 1216, 2091, 3726, 2858,  282, 3898, 2704, 3154,
+         1601, 1248, 3292, 2226,  512, 3051, 2560, 4069, 2911,  926, 2446,  108, 1265, 3306,  400, 1140},
+        {2138, 2519, 3697, 3342, 1475,  705, 3768, 2303,  353, 3954, 1182, 2118, 1016, 2888, 3619,  372,
+         3118, 1068, 2624,  327, 2107, 3585, 2670, 4014, 1274,   88, 1953,  960,  458, 2311, 3583, 3152,
+          326, 1008, 1725,  475, 1460, 2764, 3272, 1577, 3041,  132, 1767,  675, 3404, 2043,  892,   39,
+         3841,  783, 2675, 1705, 3702,  823, 1231,  305, 2280,  516, 3430, 3944,  648, 2953, 1803, 3781},
+        {1505,  325, 1842,  901, 2441, 3026,  248, 3262, 1562, 1900,  580, 3688,  162, 2282, 1775,  664,
+         2076, 3966,  811, 3384, 1659,  147, 1028, 2321, 1777, 3042, 3650, 1422, 2907, 1697,  817, 1925,
+         2266, 4094, 3112, 2097, 3561,   50, 1893, 2492,  806, 2733, 4030, 1420, 2520, 1227, 3620, 1773,
+         2278, 3502,  375, 1078, 2443, 3352, 2063, 3545, 1641, 1134, 2706, 1421, 2047, 2371,  890, 2852},
+        { 615, 3955, 2747,  168, 3867, 1727, 2088, 1034, 2799, 3421, 2507, 3115, 1401, 4057, 3264, 1246,
+         2843,   47, 1860, 2415, 3729, 2788, 3147,  533, 3439,  829,  390, 2163, 3250,  104, 3806, 1369,
+         2690,  156, 1236,  654, 2444,  978, 3976,  429, 3385, 1147, 2269, 3287,  167, 2951,  596, 2613,
+         1340, 2971, 1993, 3946,  120, 1380, 2985,  700, 3899, 3187, 1936,  302, 3127, 3625,   54, 3402},
+        {2008, 1188, 3232, 2239, 1082, 3450,  479, 4035, 1344,   97,  904, 1713, 2687,  341,  937, 2581,
+         3767, 1448, 3079, 1126,  656, 1368, 1937, 3868, 1504, 2438, 2768, 4048, 1003, 2575, 3362,  532,
+         2977, 1653, 3279, 3772, 1561, 2963, 2251, 1381, 3700, 1972,  491,  934, 1734, 2125, 3226, 4095,
+          231,  665, 3418, 1518, 2749,  525, 1814, 2589,   13, 2352,  769, 3794, 1033, 1673, 1307, 2574},
+        { 921, 3582, 1655,  564, 1431, 2834, 2524,  749, 2339, 3643, 2052, 3817,  709, 2194, 3536, 1934,
+          551, 2201, 3573,  387, 4052, 2158,  275,  953, 2928,  235, 1202, 1808,  570, 1557, 2110, 1102,
+         3901,  825, 2183, 2639,  215, 3411,  683, 1813,  260, 2662, 3021, 3544, 3891,  407, 1506, 1031,
+         1928, 2510,  935, 3119, 2219, 3810, 3466, 1057, 1485, 3586, 1783, 2820, 2499,  544, 4058, 3077},
+        {2335,  135, 2637, 3043, 3809,   10, 1640, 3330, 3040, 1539,  497, 2867, 1288, 3083, 1591,  247,
+         3017,  875, 2517, 1763, 2895, 3265, 2603, 3632, 1711, 3239, 2095, 3462, 2961, 3710,  323, 2503,
+         1881, 3529,  432, 1067, 1970, 1276, 3834, 2459, 3210,  815, 1412, 2412, 1153, 2759, 2294, 3524,
+         2923, 3715, 1757,  344, 1212,  788, 2098, 2894,  463, 3059, 1242,  249, 3320, 2222, 1820,  377},
+        {1502, 3918, 1948,  822, 2122, 3488, 1030, 1963,  241, 1071, 2247, 3416,  179, 3953, 2531, 1105,
+         3852, 1333, 3395,  160, 1464,  750, 1197, 2268,  594, 3823,  841,   37, 2307, 1308, 2824, 3429,
+          138, 1384, 2805, 4006, 3098,  488, 2823, 1019, 1618, 4015,    3, 1930,  674, 3428,  264,  793,
+         1280,  110, 2315, 4013, 2646, 3224,  170, 1628, 4043, 2192,  634, 3900, 1492,  862, 3730, 2762},
+        { 575, 1112, 3289,  308, 1327, 2491,  604, 3759, 2757, 4005, 2571, 1666,  951, 1886,  578, 3315,
+         2089, 2718,  676, 2305, 3863, 1855, 3431,  122, 2744, 1428, 2537, 1645, 3871,  929,  602, 1681,
+         2260, 3174,  708, 2392, 1675, 3584, 2031,  180, 3350, 2191, 2916, 3734, 1543, 3125, 2033, 3820,
+         2620, 1535, 3358,  633, 1416, 1897, 3732, 2453,  874, 3397, 2651, 1958, 2941,   73, 1221, 3178},
+        {2414, 3644, 1608, 2802, 4068, 3068, 1704, 2217,  380, 1379,  682, 3114, 3701, 2370, 2972, 1438,
+           98, 1797, 3675, 1060, 2669,  428, 2038, 4000,  987, 3020, 3547,  523, 3235, 1917, 3045, 4056,
+         1002, 3635, 1868,   42, 1404,  861, 2688, 3774, 1283,  526,  947, 2680,  356, 2481, 1013, 1716,
+         3027,  446, 2019, 2932, 3602,  321, 1129, 2800, 1388,  129, 1668, 1026, 3611, 2274, 3480, 1979},
+        { 895, 2931,  451, 2283,  880,  144, 3618, 1141, 3196, 3516, 2034,   43, 1267,  389, 3597,  819,
+         4087, 2925,  474, 1638, 3290, 2949, 1291, 2450, 1754,  320, 2135, 1045, 2365,  157, 2578, 1469,
+          314, 2678, 1178, 3850, 2558, 3234,  329, 1785, 2396, 3071, 1632, 3507, 1262, 4032,   92, 3316,
+          714, 3935, 1109, 2498,  905, 2249, 3141,  536, 2025, 3848, 3167,  355, 2518,  681, 1572,  288},
+        {3399, 1800, 3865, 1264, 1976, 2703, 1479, 2448,  830, 1769, 2918, 3910, 2242, 2819, 1706, 2129,
+         2469, 1172, 3495, 2386,    6,  907, 3641,  660, 3211, 3712, 1376, 2804, 3934, 1228, 3490, 2077,
+          677, 3011, 2198, 3372,  597, 2079, 1119, 3391,  732, 3895, 2004,  433, 2322, 1846, 2835, 1335,
+         2297, 1876, 3493,   67, 1707, 3986, 1466, 3481, 2959,  737, 2176, 3748, 1302, 3093, 4031, 2685},
+        {1371,   95, 2596,  644, 3557, 3212,  518, 3971,  211, 2666, 1029, 1474,  629, 3389, 1051,  212,
+         3273,  690, 1942, 1363, 3920, 2102, 1549, 2781,  145, 1984,  727, 3337,  373, 1793,  834, 3213,
+         3762, 1654,  255,  965, 2890, 1542, 4080, 2848, 1424,   74, 2617, 3291,  796, 3614,  519, 3765,
+         2648,  319, 1284, 2751, 3323,  725, 2549,  206, 1782, 1175, 2720, 1555,  501, 1910, 1007, 2186},
+        { 731, 3758, 3089, 1630, 2369,  990, 1812, 3010, 2180, 3744,  445, 3477, 1977, 2607, 3932, 1597,
+         2726, 3791,  299, 2604, 3047,  561, 3373, 2281, 1209, 4072, 2597, 1566, 2272, 3657, 2844,  425,
+         2381, 1252, 3984, 1924, 3530,  207, 2471,  484, 2206, 3668, 1038, 1523, 2983, 1159, 2144, 1588,
+          922, 2990, 3884, 2170,  442, 1997, 1050, 3622, 2313, 4090,   22, 3361, 2832, 3509,  185, 3025},
+        {2477, 2053, 1152,  363, 3937,   33, 3417, 1215,  652, 1573, 2361, 3036,  106,  855, 3100,  509,
+         1251, 2223, 3156,  776, 1811, 1135, 3773,  422, 1760, 3006,  478,  977, 3074,   29, 1440, 1960,
+          897, 2750, 3192,  541, 2300, 1042, 3627, 1821,  851, 3015, 1896, 3972,  280, 2707, 3422,  174,
+         3225, 1818,  621, 1481, 3111, 3816, 2878, 1590,  472, 2627, 1022, 2041,  779, 2405, 1702, 3649},
+        {1496,  477, 3446, 2790, 2157, 1405, 2729, 1965, 3589, 2908, 1173, 4002, 1756, 1351, 2379, 1904,
+         3682,  964, 1622, 4019, 2761,  209, 2511, 3179,  858, 2422, 3568, 2029, 3843, 1151, 2625, 3913,
+         3442,  127, 1389, 2588, 1670, 3061, 1311, 2654, 3419,  197, 2467,  600, 2301, 1759,  756, 4073,
+         2385, 1179, 3594, 2538,  911,  259, 1270, 3334,  765, 3146, 1685, 3711, 1286, 3974,  354, 1076},
+        {2909, 3876, 1856,  747, 3161, 3684,  558, 2420,  177,  846, 2130,  333, 2555, 3760, 3284,  191,
+         2898, 3444,  262, 2151, 1354, 3587, 1906, 1491, 3832,   99, 1387, 2778,  694, 1768, 3227,  591,
+         2248, 1802, 3665,  814, 3886,   20,  646, 3961, 1582, 1127, 3215, 1393, 3599, 3101, 1341, 2046,
+          540, 2792,   32, 3295, 1853, 2393, 2732, 1950, 3924, 2213,  284, 2981,  553, 2147, 2676, 3332},
+        { 117,  944, 2512, 1303,  258, 1735,  939, 4081, 3246, 1827, 3660, 3168, 1020,  482, 2166,  786,
+         1454, 2440,  625, 3268,  943, 2955,  668, 2205, 1073, 3319, 1866,  370, 3420, 2193,  271, 1527,
+         1005, 2982,  347, 2068, 2774, 3307, 1877, 2257,  351, 2755, 3842, 2081,  927,   87, 2594, 3515,
+         1672, 3807, 2164, 1128, 3992,  586, 3542,   93, 1457, 1137, 3575, 2456, 1484, 3173,  803, 1887},
+        {2333, 1636, 3260, 3967, 2075, 2644, 2984, 1500, 1145, 2714,  630, 1480, 2847, 3535, 1176, 4063,
+         1844, 2772, 3844, 1799, 2410,  123, 3993, 2623,  330, 2933, 2349, 4017,  971, 2508, 3718, 2791,
+         4065, 2399, 3374, 1148, 1459, 2429,  962, 3131, 3671,  791, 1784,  415, 2830, 3930, 1069,  322,
+         2946,  804, 1538,  376, 2960, 1677,  931, 2336, 3004,  573, 2748, 1908,   65, 3897, 1225, 3716},
+        {3471,  628, 2727,  405, 1107, 3549,  101, 2293,  410, 3831, 2372,   21, 2015, 1650, 2528, 3023,
+           90,  998, 1301,  361, 3491, 1610, 3105, 1314, 3752, 1663,  593, 1243, 3110, 1624,  728, 1297,
+          153, 1587,  689, 3771,  485, 3506,  246, 1362, 2045, 2573, 1295, 3312, 2345, 1536, 1956, 3329,
+         1271, 2494, 3205, 3681, 2290, 1258, 3266, 3717, 1786, 3839,  970, 3326,  734, 1667, 2544,  436},
+        {1094, 2006, 1443, 3706, 2375,  784, 3195, 1990, 3497, 1743,  909, 3313, 3949,  717,  352, 3479,
+         2010, 3741, 3138, 2196, 2745, 1122,  514, 2040,  844, 3501, 2699, 2136,  203, 3565, 1994, 3357,
+         3035, 2137, 2715, 1932, 3001, 1619, 4040, 2829,  572, 3533,  169, 3800,  695, 3181,  470, 2236,
+         3969,  119, 1941,  702, 2679,  217, 2069,  493, 2640,  172, 1398, 2174, 2935, 3601, 2119, 3058},
+        {4020, 2917,   46, 3048, 1838, 1530, 3940, 1294,  701, 3092, 2672, 1220, 2254, 2915, 1414,  913,
+         2351,  498, 1499,  753, 3943, 1898, 3663, 2478, 3255,   77, 1501, 3845, 2899,  534, 2638,  942,
+          409, 3846, 1035,   80, 2541,  808, 2323, 1862, 1093, 3073, 1623, 2188, 1171, 2719, 3738,  871,
+         1738, 2827, 1101, 3386, 1441, 4066, 2885,  857, 1578, 3412, 2466, 4046,  394, 1015,  186, 1517}};
+}
@@ -0,0 +1,54 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "build_plan.h"
+
+using namespace std;
+using namespace mapart;
+
+MapBuildPlan::MapBuildPlan()
+{
+}
+
+void MapBuildPlan::init(const std::vector<const minecraft::BlockDescription *> &blockTable)
+{
+    this->blockTable = blockTable;
+
+    blockIndexes.assign(BUILD_PLAN_CELLS, BUILD_PLAN_NO_BLOCK);
+    heights.assign(BUILD_PLAN_CELLS, 0);
+}
+
+size_t MapBuildPlan::size() const
+{
+    return blockIndexes.size();
+}
+
+MapBuildPlan::const_iterator MapBuildPlan::begin() const
+{
+    return const_iterator(this, 0);
+}
+
+MapBuildPlan::const_iterator MapBuildPlan::end() const
+{
+    return const_iterator(this, blockIndexes.size());
+}
@@ -0,0 +1,169 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <cstdint>
+#include <iterator>
+
+// Number of cells of a map plan (the first row is the base of the next blocks)
+#define BUILD_PLAN_CELLS (MAP_WIDTH * (MAP_HEIGHT + 1))
+
+// Block index of the cells without block
+#define BUILD_PLAN_NO_BLOCK (0xFF)
+
+namespace mapart
+{
+    /**
+     * @brief  Compact build of a map
+     * @note   Stores a block index (uint8) and a height (int16) for each cell, in rows of MAP_WIDTH,
+     *         plus a table with the block of each index for the version.
+     *         The position of each cell comes from its index (x = i % MAP_WIDTH, z = i / MAP_WIDTH).
+     *         Blocks are read as MapBuildingBlock values, by index or with the iterator.
+     * @retval None
+     */
+    class MapBuildPlan
+    {
+    public:
+        /**
+         * @brief  Iterator over the blocks of the plan
+         * @retval None
+         */
+        class const_iterator
+        {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef mapart::MapBuildingBlock value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef const mapart::MapBuildingBlock *pointer;
+            typedef mapart::MapBuildingBlock reference;
+
+            const_iterator(const MapBuildPlan *plan, size_t index) : plan(plan), index(index)
+            {
+            }
+
+            mapart::MapBuildingBlock operator*() const
+            {
+                return (*plan)[index];
+            }
+
+            const_iterator &operator++()
+            {
+                index++;
+                return *this;
+            }
+
+            bool operator==(const const_iterator &other) const
+            {
+                return index == other.index;
+            }
+
+            bool operator!=(const const_iterator &other) const
+            {
+                return index != other.index;
+            }
+
+        private:
+            const MapBuildPlan *plan;
+            size_t index;
+        };
+
+        MapBuildPlan();
+
+        /**
+         * @brief  Allocates the cells
+         * @note   Cells start without block, at height 0
+         * @param  &blockTable: Block of each block index (can be NULL)
+         * @retval None
+         */
+        void init(const std::vector<const minecraft::BlockDescription *> &blockTable);
+
+        /**
+         * @brief  Gets the number of cells
+         * @note
+         * @retval Number of cells (BUILD_PLAN_CELLS, or 0 if not initialized)
+         */
+        size_t size() const;
+
+        /**
+         * @brief  Gets a block
+         * @note
+         * @param  i: Index of the cell
+         * @retval The block (block_ptr is NULL for cells without block)
+         */
+        inline mapart::MapBuildingBlock operator[](size_t i) const
+        {
+            mapart::MapBuildingBlock block;
+            block.block_ptr = (blockIndexes[i] == BUILD_PLAN_NO_BLOCK) ? NULL : blockTable[blockIndexes[i]];
+            block.x = static_cast<int>(i % MAP_WIDTH);
+            block.y = heights[i];
+            block.z = static_cast<int>(i / MAP_WIDTH);
+            return block;
+        }
+
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /**
+         * @brief  Sets the block of a cell
+         * @note
+         * @param  i: Index of the cell
+         * @param  blockIndex: Block index (BUILD_PLAN_NO_BLOCK for no block)
+         * @retval None
+         */
+        inline void setBlockIndex(size_t i, uint8_t blockIndex)
+        {
+            blockIndexes[i] = blockIndex;
+        }
+
+        /**
+         * @brief  Gets the height of a cell
+         * @note
+         * @param  i: Index of the cell
+         * @retval The height
+         */
+        inline int getHeight(size_t i) const
+        {
+            return heights[i];
+        }
+
+        /**
+         * @brief  Sets the height of a cell
+         * @note
+         * @param  i: Index of the cell
+         * @param  height: The height
+         * @retval None
+         */
+        inline void setHeight(size_t i, int height)
+        {
+            heights[i] = static_cast<int16_t>(height);
+        }
+
+    private:
+        std::vector<uint8_t> blockIndexes;
+        std::vector<int16_t> heights;
+        std::vector<const minecraft::BlockDescription *> blockTable;
+    };
+}
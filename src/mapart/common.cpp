@@ -22,6 +22,7 @@
  */
 
 #include "common.h"
+#include "tiled_matrix.h"
 
 #include <algorithm>
 
@@ -50,6 +51,12 @@ std::string mapart::ditheringMethodToString(mapart::DitheringMethod method)
         return string("Bayer-22");
     case DitheringMethod::Ordered33:
         return string("Ordered-33");
+    case DitheringMethod::Bayer88:
+        return string("Bayer-88");
+    case DitheringMethod::Bayer1616:
+        return string("Bayer-1616");
+    case DitheringMethod::BlueNoise:
+        return string("Blue-Noise");
     default:
         return string("None");
     }
@@ -96,6 +103,18 @@ mapart::DitheringMethod mapart::parseDitheringMethodFromString(std::string str)
     {
         return DitheringMethod::Ordered33;
     }
+    else if (nameLower.compare(string("bayer-88")) == 0)
+    {
+        return DitheringMethod::Bayer88;
+    }
+    else if (nameLower.compare(string("bayer-1616")) == 0)
+    {
+        return DitheringMethod::Bayer1616;
+    }
+    else if (nameLower.compare(string("blue-noise")) == 0)
+    {
+        return DitheringMethod::BlueNoise;
+    }
     else if (nameLower.compare(string("none")) == 0)
     {
         return DitheringMethod::None;
@@ -106,48 +125,61 @@ mapart::DitheringMethod mapart::parseDitheringMethodFromString(std::string str)
     }
 }
 
-std::vector<map_color_t> mapart::getMapDataFromColorMatrix(const std::vector<const minecraft::FinalColor *> &matrix, size_t matrixW, size_t matrixH, size_t mapX, size_t mapZ)
+std::string mapart::errorDiffusionModeToString(mapart::ErrorDiffusionMode mode)
 {
-    size_t offsetX = mapX * MAP_WIDTH;
-    size_t offsetZ = mapZ * MAP_HEIGHT;
+    switch (mode)
+    {
+    case ErrorDiffusionMode::Tiled:
+        return string("Tiled");
+    case ErrorDiffusionMode::TiledSeams:
+        return string("Tiled-Seams");
+    default:
+        return string("Exact");
+    }
+}
 
-    std::vector<map_color_t> result(MAP_WIDTH * MAP_HEIGHT);
+mapart::ErrorDiffusionMode mapart::parseErrorDiffusionModeFromString(std::string str)
+{
+    std::string nameLower(str);
+    std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(), ::tolower);
 
-    for (size_t z = 0; z < MAP_HEIGHT; z++)
+    if (nameLower.compare(string("exact")) == 0)
     {
-        for (size_t x = 0; x < MAP_WIDTH; x++)
-        {
-            size_t indexInMatrix = (z + offsetZ) * matrixW + (x + offsetX);
-            size_t indexInResult = z * MAP_WIDTH + x;
-
-            result[indexInResult] = matrix[indexInMatrix]->getMapColor();
-        }
+        return ErrorDiffusionMode::Exact;
     }
+    else if (nameLower.compare(string("tiled")) == 0)
+    {
+        return ErrorDiffusionMode::Tiled;
+    }
+    else if (nameLower.compare(string("tiled-seams")) == 0 || nameLower.compare(string("seams")) == 0)
+    {
+        return ErrorDiffusionMode::TiledSeams;
+    }
+    else
+    {
+        return ErrorDiffusionMode::Unknown;
+    }
+}
 
-    return result;
+std::vector<map_color_t> mapart::getMapDataFromColorMatrix(const mapart::TiledMatrix<map_color_t> &matrix, size_t mapX, size_t mapZ)
+{
+    const map_color_t *tile = matrix.getTile(mapX, mapZ);
+
+    return std::vector<map_color_t>(tile, tile + (MAP_WIDTH * MAP_HEIGHT));
 }
 
-std::vector<const minecraft::FinalColor *> mapart::mapColorsToRGB(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<map_color_t> &mapColors)
+void mapart::validateMapColors(const std::vector<minecraft::FinalColor> &colorSet, std::vector<map_color_t> &mapColors)
 {
     size_t colorset_size = colorSet.size();
     size_t colors_size = mapColors.size();
 
-    std::vector<const minecraft::FinalColor *> result(colors_size);
-
     for (size_t i = 0; i < colors_size; i++)
     {
-        map_color_t color = mapColors[i];
-        if (color >= 0 && color < colorset_size)
+        if (mapColors[i] >= colorset_size)
         {
-            result[i] = &(colorSet[color]);
-        }
-        else
-        {
-            result[i] = &(colorSet[0]);
+            mapColors[i] = 0;
         }
     }
-
-    return result;
 }
 
 MapBuildingSupportBlock mapart::getSupportBlockOptions(const minecraft::BlockList &supportBlockList, minecraft::McVersion version, std::string supportBlockMaterial, bool supportBlocksAlways) {
@@ -23,19 +23,27 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "../colors/colors.h"
 #include "../minecraft/mc_colors.h"
 #include "../minecraft/mc_blocks.h"
 
-typedef short map_color_t;
+// Map color (one byte, as stored in the map files).
+// It is also the index of the color in the color set (see minecraft::loadFinalColors),
+// so the color set is the palette of the map colors
+typedef uint8_t map_color_t;
 
 #define MAP_WIDTH (128)
 #define MAP_HEIGHT (128)
 
 namespace mapart
 {
+    // Matrix stored by maps (see tiled_matrix.h)
+    template <typename T>
+    class TiledMatrix;
+
     /**
      * @brief  Different dithering methods
      * @note   
@@ -55,6 +63,9 @@ namespace mapart
         Bayer44 = 7,
         Bayer22 = 8,
         Ordered33 = 9,
+        Bayer88 = 10,
+        Bayer1616 = 11,
+        BlueNoise = 12,
 
         Unknown = 99
     };
@@ -75,6 +86,36 @@ namespace mapart
      * */
     mapart::DitheringMethod parseDitheringMethodFromString(std::string str);
 
+    /**
+     * @brief  Scope of the error diffusion dithering methods
+     * @note   
+     * @retval None
+     */
+    enum class ErrorDiffusionMode : short
+    {
+        Exact = 0,      // The error is diffused through the whole image
+        Tiled = 1,      // The error is confined to each map (tiles are independent)
+        TiledSeams = 2, // Same as tiled, carrying the error from the borders of the previous maps
+
+        Unknown = 99
+    };
+
+    /**
+     * @brief  Gets string representation for error diffusion mode
+     * @note   
+     * @param  mode: Error diffusion mode
+     * @retval String
+     */
+    std::string errorDiffusionModeToString(mapart::ErrorDiffusionMode mode);
+
+    /**
+     * @brief  Parses error diffusion mode from string
+     * @note   
+     * @param  str: String
+     * @retval Error diffusion mode
+     * */
+    mapart::ErrorDiffusionMode parseErrorDiffusionModeFromString(std::string str);
+
     /**
      * @brief  Map art building method
      * @note   
@@ -128,23 +169,22 @@ namespace mapart
     };
 
     /**
-     * @brief  Turns array of map colors to final colors with RGB info
-     * @note   
+     * @brief  Checks an array of map colors against the color set
+     * @note   Colors not in the color set (from a newer version) are set to 0 (transparent),
+     *         so they can be used as indexes in the color set
      * @param  &colorSet: Color set (minecraft)
      * @param  &mapColors: Array of map colors
-     * @retval Array of final colors
+     * @retval None
      */
-    std::vector<const minecraft::FinalColor *> mapColorsToRGB(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<map_color_t> &mapColors);
+    void validateMapColors(const std::vector<minecraft::FinalColor> &colorSet, std::vector<map_color_t> &mapColors);
 
     /**
      * @brief  Gets map data to save to map file
-     * @note   
-     * @param  &matrix: Color matrix
-     * @param  matrixW: Matrix width
-     * @param  matrixH: Matrix height
+     * @note   The map is a contiguous tile of the matrix, so it is copied as is
+     * @param  &matrix: Map colors (stored by maps)
      * @param  mapX: Map X coordinate
      * @param  mapZ: Map Z coordinate
      * @retval Map data
      */
-    std::vector<map_color_t> getMapDataFromColorMatrix(const std::vector<const minecraft::FinalColor *> &matrix, size_t matrixW, size_t matrixH, size_t mapX, size_t mapZ);
+    std::vector<map_color_t> getMapDataFromColorMatrix(const mapart::TiledMatrix<map_color_t> &matrix, size_t mapX, size_t mapZ);
 }
@@ -23,71 +23,280 @@
 
 #pragma once
 
-#define BAYER_44_MATRIX_H 4
-#define BAYER_44_MATRIX_W 4
+#include "common.h"
+#include "blue_noise.h"
 
-static double BAYER_44_MATRIX[BAYER_44_MATRIX_H][BAYER_44_MATRIX_W] = {
-    1, 9, 3, 11,
-    13, 5, 15, 7,
-    4, 12, 2, 10,
-    16, 8, 14, 6};
+#define ERROR_DIFFUSSION_MATRIX_H 3
+#define ERROR_DIFFUSSION_MATRIX_W 5
 
-#define BAYER_22_MATRIX_H 2
-#define BAYER_22_MATRIX_W 2
+namespace mapart
+{
+    /**
+     * @brief  Kind of dithering method
+     * @note
+     * @retval None
+     */
+    enum class DitheringKind
+    {
+        None = 0,           // Closest color
+        Ordered = 1,        // Chooses between the 2 closest colors with a threshold matrix
+        ErrorDiffusion = 2, // Diffuses the error to the next pixels
+    };
 
-static double BAYER_22_MATRIX[BAYER_22_MATRIX_H][BAYER_22_MATRIX_W] = {
-    1, 3,
-    4, 2};
+    /*
+     * Description of the dithering methods.
+     * Each method is a type, so the generation is compiled for each method.
+     *
+     * Ordered methods define:
+     *     height, width: Size of the threshold matrix
+     *     thresholds: Threshold matrix (see ThresholdMatrix)
+     *
+     * Error diffusion methods define:
+     *     weights: Matrix of weights. The pixel is at the center of the first row
+     *     divisor: Divisor of the weights
+     */
 
-#define ORDERED_33_MATRIX_H 3
-#define ORDERED_33_MATRIX_W 3
+    /**
+     * @brief  Threshold matrix of an ordered dithering method
+     * @note   Values are the ranks, from 1 to (H * W), as doubles for the comparison.
+     *         The matrix is stored transposed (rows[z % W][x % H]), so the pixels
+     *         of a row of the image read a row of the matrix.
+     * @retval None
+     */
+    template <size_t H, size_t W>
+    struct ThresholdMatrix
+    {
+        double rows[W][H];
+    };
 
-static double ORDERED_33_MATRIX[ORDERED_33_MATRIX_H][ORDERED_33_MATRIX_W] = {
-    1, 7, 4,
-    5, 8, 3,
-    6, 2, 9};
+    /**
+     * @brief  Builds a threshold matrix
+     * @note
+     * @param  &ranks: Ranks of the matrix, from 1 to (H * W)
+     * @retval The threshold matrix
+     */
+    template <size_t H, size_t W>
+    constexpr ThresholdMatrix<H, W> makeThresholdMatrix(const unsigned short (&ranks)[H][W])
+    {
+        ThresholdMatrix<H, W> m = {};
 
-#define ERROR_DIFFUSSION_MATRIX_H 3
-#define ERROR_DIFFUSSION_MATRIX_W 5
+        for (size_t i = 0; i < H; i++)
+        {
+            for (size_t j = 0; j < W; j++)
+            {
+                m.rows[j][i] = static_cast<double>(ranks[i][j]);
+            }
+        }
+
+        return m;
+    }
+
+    /**
+     * @brief  Builds the threshold matrix of a Bayer dithering method
+     * @note   The rank of each cell interleaves the bits of (i xor j) and i
+     * @retval The threshold matrix (Size must be a power of 2)
+     */
+    template <size_t Size>
+    constexpr ThresholdMatrix<Size, Size> makeBayerThresholdMatrix()
+    {
+        static_assert(Size > 1 && (Size & (Size - 1)) == 0, "Size of the Bayer matrix must be a power of 2");
+
+        unsigned short ranks[Size][Size] = {};
+        size_t bits = 0;
+
+        while ((static_cast<size_t>(1) << bits) < Size)
+        {
+            bits++;
+        }
+
+        for (size_t i = 0; i < Size; i++)
+        {
+            for (size_t j = 0; j < Size; j++)
+            {
+                size_t rank = 0;
+
+                for (size_t b = 0; b < bits; b++)
+                {
+                    size_t shift = 2 * (bits - 1 - b);
+                    rank |= (((i ^ j) >> b) & 1) << (shift + 1);
+                    rank |= ((i >> b) & 1) << shift;
+                }
+
+                ranks[i][j] = static_cast<unsigned short>(rank + 1);
+            }
+        }
+
+        return makeThresholdMatrix<Size, Size>(ranks);
+    }
+
+    struct NoDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::None;
+    };
+
+    struct Bayer22Dithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::Ordered;
+        static constexpr size_t height = 2;
+        static constexpr size_t width = 2;
+        static constexpr ThresholdMatrix<height, width> thresholds = makeBayerThresholdMatrix<2>();
+    };
 
-static double FLOYD_STEINBERG_MATRIX[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
-    0, 0, 0, 7, 0,
-    0, 3, 5, 1, 0,
-    0, 0, 0, 0, 0};
+    struct Bayer44Dithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::Ordered;
+        static constexpr size_t height = 4;
+        static constexpr size_t width = 4;
+        static constexpr ThresholdMatrix<height, width> thresholds = makeBayerThresholdMatrix<4>();
+    };
 
-static double FLOYD_STEINBERG_DIVISOR = 16;
+    struct Bayer88Dithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::Ordered;
+        static constexpr size_t height = 8;
+        static constexpr size_t width = 8;
+        static constexpr ThresholdMatrix<height, width> thresholds = makeBayerThresholdMatrix<8>();
+    };
 
-static double MINAVGERR_MATRIX[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
-    0, 0, 0, 7, 5,
-    3, 5, 7, 5, 3,
-    1, 3, 5, 3, 1};
+    struct Bayer1616Dithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::Ordered;
+        static constexpr size_t height = 16;
+        static constexpr size_t width = 16;
+        static constexpr ThresholdMatrix<height, width> thresholds = makeBayerThresholdMatrix<16>();
+    };
 
-static double MINAVGERR_DIVISOR = 48;
+    struct Ordered33Dithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::Ordered;
+        static constexpr size_t height = 3;
+        static constexpr size_t width = 3;
+        static constexpr unsigned short ranks[height][width] = {
+            {1, 7, 4},
+            {5, 8, 3},
+            {6, 2, 9}};
+        static constexpr ThresholdMatrix<height, width> thresholds = makeThresholdMatrix<height, width>(ranks);
+    };
 
-static double BURKES_MATRIX[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
-    0, 0, 0, 8, 4,
-    2, 4, 8, 4, 2,
-    0, 0, 0, 0, 0};
+    struct BlueNoiseDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::Ordered;
+        static constexpr size_t height = BLUE_NOISE_SIZE;
+        static constexpr size_t width = BLUE_NOISE_SIZE;
+        static constexpr ThresholdMatrix<height, width> thresholds = makeThresholdMatrix<height, width>(BLUE_NOISE_RANKS);
+    };
 
-static double BURKES_DIVISOR = 32;
+    struct FloydSteinbergDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::ErrorDiffusion;
+        static constexpr int divisor = 16;
+        static constexpr int weights[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
+            {0, 0, 0, 7, 0},
+            {0, 3, 5, 1, 0},
+            {0, 0, 0, 0, 0}};
+    };
 
-static double SIERRA_LITE_MATRIX[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
-    0, 0, 0, 2, 0,
-    0, 1, 1, 0, 0,
-    0, 0, 0, 0, 0};
+    struct MinAvgErrDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::ErrorDiffusion;
+        static constexpr int divisor = 48;
+        static constexpr int weights[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
+            {0, 0, 0, 7, 5},
+            {3, 5, 7, 5, 3},
+            {1, 3, 5, 3, 1}};
+    };
 
-static double SIERRA_LITE_DIVISOR = 4;
+    struct BurkesDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::ErrorDiffusion;
+        static constexpr int divisor = 32;
+        static constexpr int weights[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
+            {0, 0, 0, 8, 4},
+            {2, 4, 8, 4, 2},
+            {0, 0, 0, 0, 0}};
+    };
 
-static double STUCKI_MATRIX[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
-    0, 0, 0, 8, 4,
-    2, 4, 8, 4, 2,
-    1, 2, 4, 2, 1};
+    struct SierraLiteDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::ErrorDiffusion;
+        static constexpr int divisor = 4;
+        static constexpr int weights[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
+            {0, 0, 0, 2, 0},
+            {0, 1, 1, 0, 0},
+            {0, 0, 0, 0, 0}};
+    };
 
-static double STUCKI_DIVISOR = 42;
+    struct StuckiDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::ErrorDiffusion;
+        static constexpr int divisor = 42;
+        static constexpr int weights[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
+            {0, 0, 0, 8, 4},
+            {2, 4, 8, 4, 2},
+            {1, 2, 4, 2, 1}};
+    };
 
-static double ATKINSON_MATRIX[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
-    0, 0, 0, 1, 1,
-    0, 1, 0, 1, 0,
-    0, 0, 1, 0, 0};
+    struct AtkinsonDithering
+    {
+        static constexpr DitheringKind kind = DitheringKind::ErrorDiffusion;
+        static constexpr int divisor = 8;
+        static constexpr int weights[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W] = {
+            {0, 0, 0, 1, 1},
+            {0, 1, 0, 1, 0},
+            {0, 0, 1, 0, 0}};
+    };
 
-static double ATKINSON_DIVISOR = 8;
+    /**
+     * @brief  Calls a function with the description of a dithering method
+     * @note   The function receives an empty object of the type of the method.
+     *         New methods must be added here.
+     * @param  method: Dithering method
+     * @param  &&function: Function to call (eg, a generic lambda)
+     * @retval None
+     */
+    template <typename Function>
+    inline void dispatchDitheringMethod(DitheringMethod method, Function &&function)
+    {
+        switch (method)
+        {
+        case DitheringMethod::FloydSteinberg:
+            function(FloydSteinbergDithering());
+            break;
+        case DitheringMethod::MinAvgErr:
+            function(MinAvgErrDithering());
+            break;
+        case DitheringMethod::Burkes:
+            function(BurkesDithering());
+            break;
+        case DitheringMethod::SierraLite:
+            function(SierraLiteDithering());
+            break;
+        case DitheringMethod::Stucki:
+            function(StuckiDithering());
+            break;
+        case DitheringMethod::Atkinson:
+            function(AtkinsonDithering());
+            break;
+        case DitheringMethod::Bayer44:
+            function(Bayer44Dithering());
+            break;
+        case DitheringMethod::Bayer22:
+            function(Bayer22Dithering());
+            break;
+        case DitheringMethod::Bayer88:
+            function(Bayer88Dithering());
+            break;
+        case DitheringMethod::Bayer1616:
+            function(Bayer1616Dithering());
+            break;
+        case DitheringMethod::Ordered33:
+            function(Ordered33Dithering());
+            break;
+        case DitheringMethod::BlueNoise:
+            function(BlueNoiseDithering());
+            break;
+        default:
+            function(NoDithering());
+        }
+    }
+}
@@ -0,0 +1,216 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+#include "dithering.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Fractional bits of the error values (fixed point)
+#define ERROR_DIFFUSION_FRACTION_BITS (4)
+
+// Fractional bits of the weights of the matrix (fixed point)
+#define ERROR_DIFFUSION_WEIGHT_BITS (16)
+
+// Max value of a channel, in fixed point
+#define ERROR_DIFFUSION_MAX_VALUE (255 << ERROR_DIFFUSION_FRACTION_BITS)
+
+namespace mapart
+{
+    /**
+     * @brief  Rolling error buffer for error diffusion dithering
+     * @note   Keeps the error of the current row and the next ones
+     *         (one row per row of the matrix) in fixed point, separate from the image.
+     *         The error is added to the pixels when they are read, and clamped
+     *         only once. The rows are reused, so the pixels must be read in order
+     *         within a row, and a row can only be read after every row above
+     *         diffused its error to it (the wavefront order is valid).
+     *         Pixels can be read and diffused from different threads as long as
+     *         those accesses are ordered.
+     *         The kernel is a template parameter (see dithering.h), so the
+     *         weights equal to 0 are removed and the divisions are folded.
+     * @retval None
+     */
+    class ErrorDiffusionBuffer
+    {
+    public:
+        ErrorDiffusionBuffer();
+
+        /**
+         * @brief  Initializes the buffer
+         * @note   The error is set to 0
+         * @param  width: Width of the image
+         * @param  height: Height of the image
+         * @retval None
+         */
+        void init(size_t width, size_t height);
+
+        /**
+         * @brief  Gets a pixel with the error diffused to it
+         * @note   Clears the error of the pixel, so the row can be reused
+         * @param  original: Original color of the pixel
+         * @param  x: X coordinate
+         * @param  z: Z coordinate
+         * @param  value: Array to store the value of the pixel (fixed point), for diffuse
+         * @retval The color of the pixel, rounded
+         */
+        inline colors::Color getPixel(colors::Color original, size_t x, size_t z, int32_t value[3])
+        {
+            int32_t *error = cell(x, z);
+
+            value[0] = clampValue((static_cast<int32_t>(original.red) << ERROR_DIFFUSION_FRACTION_BITS) + error[0]);
+            value[1] = clampValue((static_cast<int32_t>(original.green) << ERROR_DIFFUSION_FRACTION_BITS) + error[1]);
+            value[2] = clampValue((static_cast<int32_t>(original.blue) << ERROR_DIFFUSION_FRACTION_BITS) + error[2]);
+
+            error[0] = 0;
+            error[1] = 0;
+            error[2] = 0;
+
+            colors::Color color;
+            color.red = static_cast<unsigned char>((value[0] + (1 << (ERROR_DIFFUSION_FRACTION_BITS - 1))) >> ERROR_DIFFUSION_FRACTION_BITS);
+            color.green = static_cast<unsigned char>((value[1] + (1 << (ERROR_DIFFUSION_FRACTION_BITS - 1))) >> ERROR_DIFFUSION_FRACTION_BITS);
+            color.blue = static_cast<unsigned char>((value[2] + (1 << (ERROR_DIFFUSION_FRACTION_BITS - 1))) >> ERROR_DIFFUSION_FRACTION_BITS);
+
+            return color;
+        }
+
+        /**
+         * @brief  Skips a pixel (transparent), discarding the error diffused to it
+         * @note   Does nothing if the buffer is not initialized
+         * @param  x: X coordinate
+         * @param  z: Z coordinate
+         * @retval None
+         */
+        inline void skipPixel(size_t x, size_t z)
+        {
+            if (rows.empty())
+            {
+                return;
+            }
+
+            int32_t *error = cell(x, z);
+
+            error[0] = 0;
+            error[1] = 0;
+            error[2] = 0;
+        }
+
+        /**
+         * @brief  Diffuses the quantization error of a pixel
+         * @note
+         * @param  x: X coordinate
+         * @param  z: Z coordinate
+         * @param  value: Value of the pixel (see getPixel)
+         * @param  newColor: Color chosen for the pixel
+         * @retval None
+         */
+        template <typename Kernel>
+        inline void diffuse(size_t x, size_t z, const int32_t value[3], colors::Color newColor)
+        {
+            int32_t quantError[3];
+            quantError[0] = value[0] - (static_cast<int32_t>(newColor.red) << ERROR_DIFFUSION_FRACTION_BITS);
+            quantError[1] = value[1] - (static_cast<int32_t>(newColor.green) << ERROR_DIFFUSION_FRACTION_BITS);
+            quantError[2] = value[2] - (static_cast<int32_t>(newColor.blue) << ERROR_DIFFUSION_FRACTION_BITS);
+
+            if (x >= ERROR_DIFFUSSION_MATRIX_W / 2 && x + ERROR_DIFFUSSION_MATRIX_W / 2 < width)
+            {
+                diffuseTaps<Kernel, false>(x, z, quantError, std::make_index_sequence<ERROR_DIFFUSSION_MATRIX_H * ERROR_DIFFUSSION_MATRIX_W>());
+            }
+            else
+            {
+                diffuseTaps<Kernel, true>(x, z, quantError, std::make_index_sequence<ERROR_DIFFUSSION_MATRIX_H * ERROR_DIFFUSSION_MATRIX_W>());
+            }
+        }
+
+    private:
+        // Rows of error, 3 channels per pixel. Row z is stored at (z % ERROR_DIFFUSSION_MATRIX_H)
+        std::vector<int32_t> rows;
+
+        size_t width;
+        size_t height;
+
+        template <typename Kernel, bool checkX, size_t... Taps>
+        inline void diffuseTaps(size_t x, size_t z, const int32_t quantError[3], std::index_sequence<Taps...>)
+        {
+            (diffuseTap<Kernel, checkX, Taps>(x, z, quantError), ...);
+        }
+
+        template <typename Kernel, bool checkX, size_t Tap>
+        inline void diffuseTap(size_t x, size_t z, const int32_t quantError[3])
+        {
+            constexpr size_t dz = Tap / ERROR_DIFFUSSION_MATRIX_W;
+            constexpr size_t column = Tap % ERROR_DIFFUSSION_MATRIX_W;
+            constexpr ptrdiff_t dx = static_cast<ptrdiff_t>(column) - (ERROR_DIFFUSSION_MATRIX_W / 2);
+            constexpr int32_t weight = tapWeight(Kernel::weights[dz][column], Kernel::divisor);
+
+            // Only the pixels after this one, with weight
+            if constexpr ((dz > 0 || dx > 0) && weight != 0)
+            {
+                size_t tx = x + dx;
+                size_t tz = z + dz;
+
+                if (dz > 0 && tz >= height)
+                {
+                    return;
+                }
+
+                if (checkX && tx >= width)
+                {
+                    return; // Out of the image (tx wraps around if negative)
+                }
+
+                int32_t *error = cell(tx, tz);
+
+                error[0] += weightError(quantError[0], weight);
+                error[1] += weightError(quantError[1], weight);
+                error[2] += weightError(quantError[2], weight);
+            }
+        }
+
+        inline static constexpr int32_t tapWeight(int weight, int divisor)
+        {
+            // weight / divisor in fixed point, rounded to nearest
+            return static_cast<int32_t>((2 * static_cast<int64_t>(weight) * (1 << ERROR_DIFFUSION_WEIGHT_BITS) + divisor) / (2 * divisor));
+        }
+
+        inline int32_t *cell(size_t x, size_t z)
+        {
+            return &rows[((z % ERROR_DIFFUSSION_MATRIX_H) * width + x) * 3];
+        }
+
+        inline static int32_t clampValue(int32_t value)
+        {
+            return value < 0 ? 0 : (value > ERROR_DIFFUSION_MAX_VALUE ? ERROR_DIFFUSION_MAX_VALUE : value);
+        }
+
+        inline static int32_t weightError(int32_t error, int32_t weight)
+        {
+            // Rounded to nearest
+            return (error * weight + (1 << (ERROR_DIFFUSION_WEIGHT_BITS - 1))) >> ERROR_DIFFUSION_WEIGHT_BITS;
+        }
+    };
+}
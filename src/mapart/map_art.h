@@ -26,6 +26,7 @@
 #include "common.h"
 #include "map_nbt.h"
 #include "map_generate.h"
+#include "palette_cache.h"
 #include "map_build.h"
 #include "map_color_set.h"
 #include "materials.h"
@@ -22,13 +22,179 @@
  */
 
 #include "map_build.h"
+#include "../threads/thread_pool.h"
 #include <algorithm>
+#include <atomic>
+
+// Columns built by each task. Contiguous, so the tasks do not write the same cache lines
+#define BUILD_COLUMNS_PER_TASK (16)
 
 using namespace std;
 using namespace mapart;
 using namespace colors;
 using namespace minecraft;
 
+/**
+ * @brief  Map to build, and where to store its blocks
+ * @retval None
+ */
+struct MapBuildTask
+{
+    size_t mapX;
+    size_t mapZ;
+    mapart::MapBuildPlan *plan;
+};
+
+/**
+ * @brief  Builds a group of columns of a map with smooth heights (staircased or flat)
+ * @note   Same result as buildMapRow with smooth = true, for BUILD_COLUMNS_PER_TASK columns.
+ *         The rows are read in order (contiguous in memory), and the heights of all the columns
+ *         are updated at once: a prefix sum along Z, vectorized across X. Then every column
+ *         is moved up so its lowest block is at 0.
+ * @param  &plan: Plan of the map
+ * @param  &colorSet: Color set (palette of the map colors)
+ * @param  tile: Map colors of the map (contiguous, see TiledMatrix::getTile)
+ * @param  fromX: First column of the group
+ * @retval None
+ */
+void buildMapColumnsSmooth(mapart::MapBuildPlan &plan, const std::vector<minecraft::FinalColor> &colorSet, const map_color_t *tile, size_t fromX)
+{
+    int32_t heights[MAP_HEIGHT + 1][BUILD_COLUMNS_PER_TASK];
+    int32_t steps[BUILD_COLUMNS_PER_TASK];
+    int32_t lowest[BUILD_COLUMNS_PER_TASK];
+
+    for (size_t x = 0; x < BUILD_COLUMNS_PER_TASK; x++)
+    {
+        heights[0][x] = 0;
+        lowest[x] = 0;
+    }
+
+    for (size_t z = 0; z < MAP_HEIGHT; z++)
+    {
+        const map_color_t *colors = &tile[z * MAP_WIDTH + fromX];
+        size_t rowIndex = (z + 1) * MAP_WIDTH + fromX;
+
+        for (size_t x = 0; x < BUILD_COLUMNS_PER_TASK; x++)
+        {
+            const minecraft::FinalColor &color = colorSet[colors[x]];
+
+            plan.setBlockIndex(rowIndex + x, static_cast<uint8_t>(color.baseColorIndex));
+
+            // Light is 1 up, dark is 1 down
+            McColorType colorType = color.colorType;
+            steps[x] = (colorType == McColorType::LIGHT) ? 1 : ((colorType == McColorType::DARK) ? -1 : 0);
+        }
+
+        const int32_t *prev = heights[z];
+        int32_t *current = heights[z + 1];
+
+        for (size_t x = 0; x < BUILD_COLUMNS_PER_TASK; x++)
+        {
+            int32_t height = prev[x] + steps[x];
+            current[x] = height;
+            lowest[x] = (height < lowest[x]) ? height : lowest[x];
+        }
+    }
+
+    // Set down to 1, so 0 is the min for base blocks
+    for (size_t z = 0; z < (MAP_HEIGHT + 1); z++)
+    {
+        for (size_t x = 0; x < BUILD_COLUMNS_PER_TASK; x++)
+        {
+            heights[z][x] -= lowest[x];
+        }
+    }
+
+    for (size_t z = 0; z < (MAP_HEIGHT + 1); z++)
+    {
+        size_t rowIndex = z * MAP_WIDTH + fromX;
+
+        for (size_t x = 0; x < BUILD_COLUMNS_PER_TASK; x++)
+        {
+            plan.setHeight(rowIndex + x, heights[z][x]);
+        }
+    }
+}
+
+/**
+ * @brief  Builds maps in the thread pool
+ * @note   The columns of every map are split in groups, taken by the threads in order.
+ *         Each column only depends on the colors, so the result is the same for any number of threads.
+ *         Progress is reported in columns. Throws -1 if the task is cancelled
+ * @param  &maps: Maps to build (the plans must be initialized)
+ * @param  &colorSet: Color set (palette of the map colors)
+ * @param  smooth: True to build smooth (staircase), false to optimize the height (chaos)
+ * @param  threadsNum: Max number of threads
+ * @retval None
+ */
+void buildMapsColumns(const std::vector<MapBuildTask> &maps, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, bool smooth, size_t threadsNum, threading::Progress &p)
+{
+    const threading::CancellationToken &cancel = p.getCancellationToken();
+
+    size_t groupsPerMap = MAP_WIDTH / BUILD_COLUMNS_PER_TASK;
+    size_t groups = maps.size() * groupsPerMap;
+    size_t tasks = max(min(threadsNum, groups), static_cast<size_t>(1));
+
+    std::atomic<size_t> nextGroup(0);
+
+    threading::getThreadPool().run(tasks, [&](size_t id) {
+        size_t columnsDone = 0;
+
+        while (!cancel.isCancelled())
+        {
+            size_t group = nextGroup.fetch_add(1, std::memory_order_relaxed);
+
+            if (group >= groups)
+            {
+                break;
+            }
+
+            const MapBuildTask &map = maps[group / groupsPerMap];
+            size_t fromX = (group % groupsPerMap) * BUILD_COLUMNS_PER_TASK;
+
+            if (smooth)
+            {
+                buildMapColumnsSmooth(*map.plan, colorSet, matrix.getTile(map.mapX, map.mapZ), fromX);
+            }
+            else
+            {
+                for (size_t x = fromX; x < fromX + BUILD_COLUMNS_PER_TASK; x++)
+                {
+                    buildMapRow(*map.plan, colorSet, matrix, map.mapX, map.mapZ, x, smooth);
+                }
+            }
+
+            columnsDone += BUILD_COLUMNS_PER_TASK;
+
+            p.setProgress(static_cast<unsigned int>(id), static_cast<unsigned int>(columnsDone));
+        }
+    });
+
+    if (cancel.isCancelled())
+    {
+        throw -1;
+    }
+}
+
+/**
+ * @brief  Gets the block of each base color
+ * @note   The block index of a plan is the base color index
+ * @param  version: Minecraft version
+ * @param  &blockSet: Block set
+ * @retval The block table
+ */
+std::vector<const minecraft::BlockDescription *> getBlockTable(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet)
+{
+    std::vector<const minecraft::BlockDescription *> blockTable(blockSet.size());
+
+    for (size_t i = 0; i < blockSet.size(); i++)
+    {
+        blockTable[i] = blockSet[i].getBlockDescription(version);
+    }
+
+    return blockTable;
+}
+
 void mapart::applyBuildRestrictions(std::vector<minecraft::FinalColor> &colorSet, MapBuildMethod method)
 {
     if (method == MapBuildMethod::None)
@@ -52,7 +218,7 @@ void mapart::applyBuildRestrictions(std::vector<minecraft::FinalColor> &colorSet
     }
 }
 
-std::vector<mapart::MapBuildingBlock> mapart::buildMap(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, const std::vector<const minecraft::FinalColor *> &matrix, size_t matrixW, size_t matrixH, size_t mapX, size_t mapZ, mapart::MapBuildMethod buildMethod, size_t threadsNum, threading::Progress &p)
+mapart::MapBuildPlan mapart::buildMap(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, size_t mapX, size_t mapZ, mapart::MapBuildMethod buildMethod, size_t threadsNum, threading::Progress &p)
 {
     bool smooth = true;
 
@@ -61,21 +227,54 @@ std::vector<mapart::MapBuildingBlock> mapart::buildMap(minecraft::McVersion vers
         smooth = false;
     }
 
-    std::vector<mapart::MapBuildingBlock> blocks(MAP_WIDTH * (MAP_HEIGHT + 1));
+    mapart::MapBuildPlan plan;
+    plan.init(getBlockTable(version, blockSet));
+
+    std::vector<MapBuildTask> maps(1);
+    maps[0].mapX = mapX;
+    maps[0].mapZ = mapZ;
+    maps[0].plan = &plan;
+
+    buildMapsColumns(maps, colorSet, matrix, smooth, threadsNum, p);
+
+    return plan;
+}
+
+void mapart::buildMaps(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, mapart::MapBuildMethod buildMethod, size_t threadsNum, threading::Progress &p, std::vector<mapart::MapBuildPlan> &chunks)
+{
+    bool smooth = (buildMethod != MapBuildMethod::Chaos);
+
+    std::vector<const minecraft::BlockDescription *> blockTable = getBlockTable(version, blockSet);
+
+    size_t mapsCountX = matrix.getMapsCountX();
+    size_t mapsCountZ = matrix.getMapsCountZ();
+
+    chunks.resize(mapsCountX * mapsCountZ);
 
-    for (size_t x = 0; x < MAP_WIDTH; x++)
+    std::vector<MapBuildTask> maps(chunks.size());
+
+    for (size_t mapZ = 0; mapZ < mapsCountZ; mapZ++)
     {
-        buildMapRow(version, blockSet, blocks, matrix, matrixW, matrixH, mapX, mapZ, x, smooth);
-        p.setProgress(0, static_cast<unsigned int>(x + 1));
+        for (size_t mapX = 0; mapX < mapsCountX; mapX++)
+        {
+            size_t i = mapZ * mapsCountX + mapX;
+
+            // Filled in place by the threads
+            chunks[i].init(blockTable);
+
+            maps[i].mapX = mapX;
+            maps[i].mapZ = mapZ;
+            maps[i].plan = &chunks[i];
+        }
     }
 
-    return blocks;
+    buildMapsColumns(maps, colorSet, matrix, smooth, threadsNum, p);
 }
 
-void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, std::vector<mapart::MapBuildingBlock> &blockMatrix, const std::vector<const minecraft::FinalColor *> &matrix, size_t matrixW, size_t matrixH, size_t mapX, size_t mapZ, size_t x, bool smooth)
+void mapart::buildMapRow(mapart::MapBuildPlan &plan, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, size_t mapX, size_t mapZ, size_t x, bool smooth)
 {
-    size_t offsetX = mapX * MAP_WIDTH;
-    size_t offsetZ = mapZ * MAP_HEIGHT;
+    // Map colors of the map, contiguous
+    const map_color_t *tile = matrix.getTile(mapX, mapZ);
 
     vector<Plateau> plateaus(1);
     size_t currentPlateau = 0;
@@ -84,10 +283,8 @@ void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecra
 
     int lowestY = 0;
 
-    blockMatrix[x].block_ptr = NULL;
-    blockMatrix[x].x = static_cast<int>(x);
-    blockMatrix[x].z = 0;
-    blockMatrix[x].y = 0;
+    plan.setBlockIndex(x, BUILD_PLAN_NO_BLOCK);
+    plan.setHeight(x, 0);
 
     plateaus[0].start = 0;
     plateaus[0].end = 0;
@@ -95,33 +292,27 @@ void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecra
     for (size_t z = 0; z < MAP_HEIGHT; z++)
     {
         size_t indexBlockMatrix = (z + 1) * MAP_WIDTH + x;
-        size_t indexInMatrix = (z + offsetZ) * matrixW + (x + offsetX);
-
-        // Position
-        blockMatrix[indexBlockMatrix].x = static_cast<int>(x);
-        blockMatrix[indexBlockMatrix].z = static_cast<int>(z + 1);
-
         // Color
-        const minecraft::FinalColor *color = matrix[indexInMatrix];
+        const minecraft::FinalColor *color = &colorSet[tile[z * MAP_WIDTH + x]];
 
         // Block
-        blockMatrix[indexBlockMatrix].block_ptr = blockSet[color->baseColorIndex].getBlockDescription(version);
+        plan.setBlockIndex(indexBlockMatrix, static_cast<uint8_t>(color->baseColorIndex));
 
         // Y level
-        int prevIndex = static_cast<int>((z)*MAP_WIDTH + x);
-        int prevY = blockMatrix[prevIndex].y;
+        size_t prevIndex = (z)*MAP_WIDTH + x;
+        int prevY = plan.getHeight(prevIndex);
 
         switch (color->colorType)
         {
         case McColorType::LIGHT:
             // 1 up
-            blockMatrix[indexBlockMatrix].y = prevY + 1;
+            plan.setHeight(indexBlockMatrix, prevY + 1);
             ascending = true;
             currentPlateauStartIndex = z + 1;
             break;
         case McColorType::DARK:
             // 1 down
-            blockMatrix[indexBlockMatrix].y = prevY - 1;
+            plan.setHeight(indexBlockMatrix, prevY - 1);
             if (lowestY > prevY - 1)
             {
                 lowestY = prevY - 1;
@@ -137,7 +328,7 @@ void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecra
             break;
         default:
             // Normal
-            blockMatrix[indexBlockMatrix].y = prevY;
+            plan.setHeight(indexBlockMatrix, prevY);
         }
     }
 
@@ -157,11 +348,11 @@ void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecra
             int pullDownHeight = 256;
             for (size_t z = plateaus[i].end; z < plateaus[i + 1].start; z++)
             {
-                pullDownHeight = min(blockMatrix[z * MAP_WIDTH + x].y, pullDownHeight);
+                pullDownHeight = min(plan.getHeight(z * MAP_WIDTH + x), pullDownHeight);
             }
             for (size_t z = plateaus[i].end; z < plateaus[i + 1].start; z++)
             {
-                blockMatrix[z * MAP_WIDTH + x].y -= pullDownHeight;
+                plan.setHeight(z * MAP_WIDTH + x, plan.getHeight(z * MAP_WIDTH + x) - pullDownHeight);
             }
 
             pullDownNext = pullDownHeight;
@@ -169,7 +360,7 @@ void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecra
             int plateauPulldownHeight = min(pullDownPrev, pullDownNext);
             for (size_t z = plateaus[i].start; z < plateaus[i].end; z++)
             {
-                blockMatrix[z * MAP_WIDTH + x].y -= plateauPulldownHeight;
+                plan.setHeight(z * MAP_WIDTH + x, plan.getHeight(z * MAP_WIDTH + x) - plateauPulldownHeight);
             }
 
             pullDownPrev = pullDownNext;
@@ -181,7 +372,7 @@ void mapart::buildMapRow(minecraft::McVersion version, const std::vector<minecra
         for (size_t z = 0; z < (MAP_HEIGHT + 1); z++)
         {
             size_t indexBlockMatrix = (z)*MAP_WIDTH + x;
-            blockMatrix[indexBlockMatrix].y -= lowestY;
+            plan.setHeight(indexBlockMatrix, plan.getHeight(indexBlockMatrix) - lowestY);
         }
     }
 }
@@ -24,6 +24,8 @@
 #pragma once
 
 #include "common.h"
+#include "build_plan.h"
+#include "tiled_matrix.h"
 #include "../threads/progress.h"
 
 namespace mapart {
@@ -39,34 +41,48 @@ namespace mapart {
     /**
      * @brief  Builds map row
      * @note   
-     * @param  version: 
-     * @param  &blockSet: 
-     * @param  &blockMatrix: 
-     * @param  &matrix: 
-     * @param  matrixW: 
-     * @param  matrixH: 
+     * @param  &plan: Plan of the map (initialized)
+     * @param  &colorSet: Color set (palette of the map colors)
+     * @param  &matrix: Map colors of the map art (stored by maps)
      * @param  mapX: 
      * @param  mapZ: 
      * @param  x: 
      * @param  smooth: 
      * @retval None
      */
-    void buildMapRow(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, std::vector<mapart::MapBuildingBlock> &blockMatrix, const std::vector<const minecraft::FinalColor *> &matrix, size_t matrixW, size_t matrixH, size_t mapX, size_t mapZ, size_t x, bool smooth);
+    void buildMapRow(mapart::MapBuildPlan &plan, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, size_t mapX, size_t mapZ, size_t x, bool smooth);
     
     /**
      * @brief  Builds map
-     * @note   
+     * @note   The columns are built in parallel. Progress is reported in columns (MAP_WIDTH in total).
+     *         Throws -1 if the task is cancelled (see threading::Progress::getCancellationToken)
      * @param  version: 
      * @param  &blockSet: 
-     * @param  &matrix: 
-     * @param  matrixW: 
-     * @param  matrixH: 
+     * @param  &colorSet: Color set (palette of the map colors)
+     * @param  &matrix: Map colors of the map art (stored by maps)
      * @param  mapX: 
      * @param  mapZ: 
      * @param  buildMethod: 
      * @param  threadsNum: 
      * @param  &p: 
-     * @retval 
+     * @retval The plan of the map
+     */
+    mapart::MapBuildPlan buildMap(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, size_t mapX, size_t mapZ, mapart::MapBuildMethod buildMethod, size_t threadsNum, threading::Progress &p);
+
+    /**
+     * @brief  Builds all the maps of the map art
+     * @note   Maps and columns are built in parallel, with the same result as buildMap for each map.
+     *         Progress is reported in columns (number of maps * MAP_WIDTH in total).
+     *         Throws -1 if the task is cancelled (see threading::Progress::getCancellationToken)
+     * @param  version: Minecraft version
+     * @param  &blockSet: Block set
+     * @param  &colorSet: Color set (palette of the map colors)
+     * @param  &matrix: Map colors of the map art (stored by maps)
+     * @param  buildMethod: Build method
+     * @param  threadsNum: Max number of threads
+     * @param  &p: Progress
+     * @param  &chunks: Vector to store the plan of each map (index mapZ * matrix.getMapsCountX() + mapX)
+     * @retval None
      */
-    std::vector<mapart::MapBuildingBlock> buildMap(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, const std::vector<const minecraft::FinalColor *> &matrix, size_t matrixW, size_t matrixH, size_t mapX, size_t mapZ, mapart::MapBuildMethod buildMethod, size_t threadsNum, threading::Progress &p);
+    void buildMaps(minecraft::McVersion version, const std::vector<minecraft::BlockList> &blockSet, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TiledMatrix<map_color_t> &matrix, mapart::MapBuildMethod buildMethod, size_t threadsNum, threading::Progress &p, std::vector<mapart::MapBuildPlan> &chunks);
 }
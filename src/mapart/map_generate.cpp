@@ -22,283 +22,590 @@
  */
 
 #include "map_generate.h"
+#include "palette_lut.h"
+#include "palette_index.h"
+#include "palette_simd.h"
+#include "palette_memo.h"
+#include "palette_cache.h"
+#include "error_diffusion.h"
 #include "dithering.h"
+#include "../colors/cielab.h"
+#include "../threads/thread_pool.h"
 #include <algorithm>
+#include <atomic>
+#include <stdexcept>
 #include <thread>
 
+/*
+ * Error diffusion spreads the error up to 2 pixels to the right and 2 rows below.
+ * A row can compute a pixel once the previous row has computed the pixels up to
+ * 4 columns to the right. Every pixel then receives all its error before being read,
+ * threads never write the same error at the same time, and the rows of the error
+ * buffer are read before being reused. The error is added in fixed point,
+ * so the result is the same as the serial loop.
+ */
+#define WAVEFRONT_LAG (5)
+
+// Number of checks before yielding while waiting for the previous row
+#define WAVEFRONT_SPINS (64)
+
+// Pixels of the previous maps (left and top) dithered to carry their error into a map (ErrorDiffusionMode::TiledSeams)
+#define TILE_SEAM_SIZE (8)
+
+// Pixels of the next map (right) dithered to carry their error into the rows below
+#define TILE_SEAM_RIGHT (ERROR_DIFFUSSION_MATRIX_W / 2)
+
+// Rows are taken by the threads in chunks of about this number of pixels
+#define GENERATE_CHUNK_PIXELS (2048)
+
+// Minimum number of pixels per thread, starting a thread costs more than matching less pixels
+#define GENERATE_MIN_PIXELS_PER_THREAD (MAP_WIDTH * MAP_HEIGHT / 4)
+
+// Entries of the cache of L*ab conversions used to compute the L*ab plane (power of 2)
+#define LAB_PLANE_CACHE_SIZE (4096)
+
+// Minimum number of pixels per thread to compute the L*ab plane
+#define LAB_PLANE_MIN_PIXELS_PER_THREAD (16384)
+
 using namespace std;
 using namespace colors;
 using namespace mapart;
 
-inline Color applyErrorSimple(Color color, ColorError quantError, double weight)
+/**
+ * @brief  Finds the closest color of a pixel, using the memo cache
+ * @note
+ * @param  &paletteSearch: Search structures
+ * @param  &memo: Memo cache of the thread
+ * @param  *matrix: Color matrix
+ * @param  index: Index of the pixel
+ * @retval The index inside the color set
+ */
+inline size_t findClosestColorMemo(const PaletteSearch &paletteSearch, PaletteMemo &memo, const colors::Color *matrix, size_t index)
 {
-    Color result;
-    result.red = static_cast<unsigned char>(
-        min(
-            max(
-                (double)color.red + (weight * quantError.red),
-                (double)0),
-            (double)255));
-    result.green = static_cast<unsigned char>(
-        min(
-            max(
-                (double)color.green + (weight * quantError.green),
-                (double)0),
-            (double)255));
-
-    result.blue = static_cast<unsigned char>(
-        min(
-            max(
-                (double)color.blue + (weight * quantError.blue),
-                (double)0),
-            (double)255));
+    size_t closest;
 
-    return result;
+    if (!paletteSearch.useMemo || !memo.isEnabled())
+    {
+        return paletteSearch.findClosestPixelColor(matrix, index);
+    }
+
+    if (!memo.findClosestColor(matrix[index], &closest))
+    {
+        closest = paletteSearch.findClosestPixelColor(matrix, index);
+        memo.storeClosestColor(matrix[index], closest);
+    }
+
+    return closest;
+}
+
+/**
+ * @brief  Finds the closest color, using the memo cache
+ * @note   For the error diffusion methods (the color is not the one of the image)
+ * @param  &paletteSearch: Search structures
+ * @param  &memo: Memo cache of the thread
+ * @param  color: Color (RGB)
+ * @retval The index inside the color set
+ */
+inline size_t findClosestColorMemo(const PaletteSearch &paletteSearch, PaletteMemo &memo, colors::Color color)
+{
+    size_t closest;
+
+    if (!paletteSearch.useMemo || !memo.isEnabled())
+    {
+        return paletteSearch.findClosestColor(color);
+    }
+
+    if (!memo.findClosestColor(color, &closest))
+    {
+        closest = paletteSearch.findClosestColor(color);
+        memo.storeClosestColor(color, closest);
+    }
+
+    return closest;
 }
 
-void applyErrorDiffussion(std::vector<colors::Color> &colorMatrix, size_t width, size_t height, Color oldPixel, Color newPixel, size_t x, size_t z, double matrix[ERROR_DIFFUSSION_MATRIX_H][ERROR_DIFFUSSION_MATRIX_W], double divisor)
+/**
+ * @brief  Finds the 2 closest colors of a pixel, using the memo cache
+ * @note
+ * @param  &paletteSearch: Search structures
+ * @param  &memo: Memo cache of the thread
+ * @param  *matrix: Color matrix
+ * @param  index: Index of the pixel
+ * @retval The 2 closest colors and their distances
+ */
+inline minecraft::ClosestColorPair findClosestColorPairMemo(const PaletteSearch &paletteSearch, PaletteMemo &memo, const colors::Color *matrix, size_t index)
 {
-    ColorError quantError;
-    quantError.red = (short)oldPixel.red - (short)newPixel.red;
-    quantError.green = (short)oldPixel.green - (short)newPixel.green;
-    quantError.blue = (short)oldPixel.blue - (short)newPixel.blue;
+    minecraft::ClosestColorPair pair;
 
-    double weight;
-    size_t index;
+    if (!paletteSearch.useMemo || !memo.isEnabled())
+    {
+        return paletteSearch.findClosestPixelColorPair(matrix, index);
+    }
 
-    // 1 right
-    if ((x + 1) < width)
+    if (!memo.findClosestColorPair(matrix[index], &pair))
     {
-        index = (z)*width + (x + 1);
-        weight = matrix[0][3] / divisor;
-        colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+        pair = paletteSearch.findClosestPixelColorPair(matrix, index);
+        memo.storeClosestColorPair(matrix[index], pair);
+    }
+
+    return pair;
+}
+
+/**
+ * @brief  Rows of the image to generate
+ * @note   Coordinates are of the whole image. The color matrix (and its L*ab plane
+ *         and transparency) starts at row matrixZ, the result starts at row fromZ.
+ *         matrixZ is lower than fromZ when the rows above are needed
+ *         (seams of ErrorDiffusionMode::TiledSeams)
+ * @retval None
+ */
+struct GenerateBand
+{
+    size_t fromZ;
+    size_t toZ;
+    size_t matrixZ;
+};
+
+/**
+ * @brief  Computes the color of a pixel
+ * @note   Error diffusion methods diffuse the error to the pixels to the right and below.
+ *         Ordered methods are computed by rows (see generateOrderedRow).
+ *         Method is the description of the dithering method (see dithering.h)
+ * @param  x: X coordinate of the pixel
+ * @param  z: Z coordinate of the pixel
+ * @param  &band: Rows being generated
+ * @retval None
+ */
+template <typename Method>
+inline void generatePixel(size_t x, size_t z, const GenerateBand &band, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, PaletteMemo &memo, ErrorDiffusionBuffer &diffusion, const colors::Color *matrix, const mapart::TransparencyMask &transparency, size_t width, bool preserveTransparency, std::vector<size_t> &counts)
+{
+    size_t index = (z - band.matrixZ) * width + x;
+    size_t resultIndex = (z - band.fromZ) * width + x;
 
-        // 2 right
-        if ((x + 2) < width)
+    if (preserveTransparency && transparency.isTransparent(index))
+    {
+        result[resultIndex] = 0; // Void
+        if constexpr (Method::kind == DitheringKind::ErrorDiffusion)
         {
-            index = (z)*width + (x + 2);
-            weight = matrix[0][4] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            diffusion.skipPixel(x, z);
         }
+        return;
+    }
+
+    if constexpr (Method::kind == DitheringKind::ErrorDiffusion)
+    {
+        int32_t value[3];
+        colors::Color color = diffusion.getPixel(matrix[index], x, z, value);
+        size_t closest = findClosestColorMemo(paletteSearch, memo, color);
+        result[resultIndex] = static_cast<map_color_t>(closest);
+        diffusion.template diffuse<Method>(x, z, value, colorSet[closest].color);
+    }
+    else
+    {
+        // None (No dithering)
+        size_t closest = findClosestColorMemo(paletteSearch, memo, matrix, index);
+        result[resultIndex] = static_cast<map_color_t>(closest);
     }
 
-    // Row below
-    if ((z + 1) < height)
+    counts[colorSet[result[resultIndex]].baseColorIndex]++;
+}
+
+/**
+ * @brief  Buffers of a row, for the ordered dithering methods
+ * @retval None
+ */
+struct OrderedDitheringRow
+{
+    // 2 closest colors of each pixel
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> second;
+    std::vector<double> distFirst;
+    std::vector<double> distSecond;
+
+    // Threshold of each pixel (rank in the matrix)
+    std::vector<double> thresholds;
+};
+
+/**
+ * @brief  Computes the colors of a row with an ordered dithering method
+ * @note   The 2 closest colors are searched first, then all the pixels
+ *         are compared against the threshold matrix at once (vectorized).
+ *         Method is the description of the dithering method (see dithering.h)
+ * @param  z: Z coordinate of the row
+ * @param  &band: Rows being generated
+ * @param  &row: Buffers of the row
+ * @retval None
+ */
+template <typename Method>
+void generateOrderedRow(size_t z, const GenerateBand &band, OrderedDitheringRow &row, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, PaletteMemo &memo, const colors::Color *matrix, const mapart::TransparencyMask &transparency, size_t width, bool preserveTransparency, std::vector<size_t> &counts)
+{
+    size_t rowIndex = (z - band.matrixZ) * width;
+    size_t resultRowIndex = (z - band.fromZ) * width;
+
+    for (size_t x = 0; x < width; x++)
     {
-        // 1 down, 1 left
-        if (x > 0)
+        if (preserveTransparency && transparency.isTransparent(rowIndex + x))
         {
-            index = (z + 1) * width + (x - 1);
-            weight = matrix[1][1] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            // The first color is always chosen (void)
+            row.first[x] = 0;
+            row.second[x] = 0;
+            row.distFirst[x] = 0;
+            row.distSecond[x] = 0;
+            continue;
         }
 
-        // 1 down, 2 left
-        if (x > 1)
+        minecraft::ClosestColorPair closest2 = findClosestColorPairMemo(paletteSearch, memo, matrix, rowIndex + x);
+        row.first[x] = static_cast<uint32_t>(closest2.first);
+        row.second[x] = static_cast<uint32_t>(closest2.second);
+        row.distFirst[x] = closest2.distFirst;
+        row.distSecond[x] = closest2.distSecond;
+    }
+
+    // The row of the matrix repeats along the row of the image
+    const double *matrixRow = Method::thresholds.rows[z % Method::width];
+
+    for (size_t x = 0; x < width; x += Method::height)
+    {
+        std::copy_n(matrixRow, min(Method::height, width - x), &row.thresholds[x]);
+    }
+
+    uint32_t *first = row.first.data();
+    const uint32_t *second = row.second.data();
+    const double *distFirst = row.distFirst.data();
+    const double *distSecond = row.distSecond.data();
+    const double *thresholds = row.thresholds.data();
+    const double levels = static_cast<double>(Method::height * Method::width + 1);
+
+    // Exactly (distFirst * levels) / distSecond > rank. If both distances are 0 it is false (NaN), so the first is chosen
+    for (size_t x = 0; x < width; x++)
+    {
+        first[x] = (((distFirst[x] * levels) / distSecond[x]) > thresholds[x]) ? second[x] : first[x];
+    }
+
+    for (size_t x = 0; x < width; x++)
+    {
+        result[resultRowIndex + x] = static_cast<map_color_t>(first[x]);
+
+        if (!(preserveTransparency && transparency.isTransparent(rowIndex + x)))
         {
-            index = (z + 1) * width + (x - 2);
-            weight = matrix[1][0] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            counts[colorSet[first[x]].baseColorIndex]++;
         }
+    }
+}
+
+template <typename Method>
+void threadGenerateMapFunc(int id, std::atomic<size_t> &nextChunk, size_t chunkRows, const GenerateBand &band, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, ErrorDiffusionBuffer &diffusion, const colors::Color *matrix, const mapart::TransparencyMask &transparency, size_t width, bool preserveTransparency, threading::Progress &progress, const threading::CancellationToken &cancel, std::vector<size_t> &counts, PaletteMemoStats &memoStats)
+{
+    PaletteMemo memo;
+    OrderedDitheringRow row;
+
+    if constexpr (Method::kind == DitheringKind::Ordered)
+    {
+        row.first.resize(width);
+        row.second.resize(width);
+        row.distFirst.resize(width);
+        row.distSecond.resize(width);
+        row.thresholds.resize(width);
+    }
+
+    size_t rowsDone = 0;
 
-        // 1 down
-        index = (z + 1) * width + (x);
-        weight = matrix[1][2] / divisor;
-        colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+    // Chunks are taken in order. Threads that find cheap rows (transparent or cached) just take more chunks
+    while (!cancel.isCancelled())
+    {
+        size_t fromZ = band.fromZ + nextChunk.fetch_add(1, std::memory_order_relaxed) * chunkRows;
 
-        // 1 down, 1 right
-        if ((x + 1) < width)
+        if (fromZ >= band.toZ)
         {
-            index = (z + 1) * width + (x + 1);
-            weight = matrix[1][3] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            break;
         }
 
-        // 1 down, 2 right
-        if ((x + 1) < width)
+        size_t toZ = min(fromZ + chunkRows, band.toZ);
+
+        for (size_t z = fromZ; z < toZ; z++)
         {
-            index = (z + 1) * width + (x + 2);
-            weight = matrix[1][4] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            size_t rowIndex = (z - band.matrixZ) * width;
+            size_t transparentPixels = preserveTransparency ? transparency.countTransparent(rowIndex, rowIndex + width) : 0;
+
+            // Fully transparent rows are void (error diffusion still has to skip the pixels)
+            if (Method::kind != DitheringKind::ErrorDiffusion && transparentPixels == width)
+            {
+                std::fill(result + (z - band.fromZ) * width, result + (z - band.fromZ + 1) * width, static_cast<map_color_t>(0));
+                continue;
+            }
+
+            // Fully opaque rows do not check the transparency of each pixel
+            bool rowTransparency = transparentPixels > 0;
+
+            if constexpr (Method::kind == DitheringKind::Ordered)
+            {
+                generateOrderedRow<Method>(z, band, row, result, colorSet, paletteSearch, memo, matrix, transparency, width, rowTransparency, counts);
+            }
+            else
+            {
+                for (size_t x = 0; x < width; x++)
+                {
+                    generatePixel<Method>(x, z, band, result, colorSet, paletteSearch, memo, diffusion, matrix, transparency, width, rowTransparency, counts);
+                }
+            }
         }
+
+        rowsDone += toZ - fromZ;
+
+        progress.setProgress(static_cast<unsigned int>(id), static_cast<unsigned int>(rowsDone));
     }
 
-    // 2nd Row below
-    if ((z + 2) < height)
+    memoStats = memo.getStats();
+}
+
+/**
+ * @brief  Waits until a row has computed a number of pixels
+ * @note
+ * @param  &row: The row
+ * @param  needed: Number of pixels needed
+ * @param  &cancel: Cancellation token
+ * @retval False if cancelled
+ */
+inline bool waitWavefrontRow(const WavefrontRow &row, size_t needed, const threading::CancellationToken &cancel)
+{
+    size_t spins = 0;
+
+    while (row.done.load(std::memory_order_acquire) < needed)
     {
-        // 2 down, 1 left
-        if (x > 0)
+        if (cancel.isCancelled())
         {
-            index = (z + 2) * width + (x - 1);
-            weight = matrix[2][1] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            return false;
         }
 
-        // 2 down, 2 left
-        if (x > 1)
+        if (++spins > WAVEFRONT_SPINS)
         {
-            index = (z + 2) * width + (x - 2);
-            weight = matrix[2][0] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            std::this_thread::yield();
         }
+    }
+
+    return true;
+}
+
+template <typename Method>
+void threadGenerateMapWavefrontFunc(int id, std::atomic<size_t> &nextRow, std::vector<WavefrontRow> &rows, const GenerateBand &band, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, ErrorDiffusionBuffer &diffusion, const colors::Color *matrix, const mapart::TransparencyMask &transparency, size_t width, bool preserveTransparency, threading::Progress &progress, const threading::CancellationToken &cancel, std::vector<size_t> &counts, PaletteMemoStats &memoStats)
+{
+    PaletteMemo memo;
+    size_t rowsDone = 0;
 
-        // 2 down
-        index = (z + 2) * width + (x);
-        weight = matrix[2][2] / divisor;
-        colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+    while (!cancel.isCancelled())
+    {
+        // Rows are taken in order, so the previous row is always being computed or done
+        size_t r = nextRow.fetch_add(1); // Row of the band
+        size_t z = band.fromZ + r;
 
-        // 2 down, 1 right
-        if ((x + 1) < width)
+        if (z >= band.toZ)
         {
-            index = (z + 2) * width + (x + 1);
-            weight = matrix[2][3] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            break;
         }
 
-        // 2 down, 2 right
-        if ((x + 1) < width)
+        size_t available = (r == 0) ? width : 0; // Pixels of the previous row already computed
+
+        // Fully opaque rows do not check the transparency of each pixel
+        size_t rowIndex = (z - band.matrixZ) * width;
+        bool rowTransparency = preserveTransparency && transparency.countTransparent(rowIndex, rowIndex + width) > 0;
+
+        for (size_t x = 0; x < width; x++)
         {
-            index = (z + 2) * width + (x + 2);
-            weight = matrix[2][4] / divisor;
-            colorMatrix[index] = applyErrorSimple(colorMatrix[index], quantError, weight);
+            size_t needed = min(x + WAVEFRONT_LAG, width);
+
+            if (available < needed)
+            {
+                if (!waitWavefrontRow(rows[r - 1], needed, cancel))
+                {
+                    memoStats = memo.getStats();
+                    return;
+                }
+                available = rows[r - 1].done.load(std::memory_order_acquire);
+            }
+
+            generatePixel<Method>(x, z, band, result, colorSet, paletteSearch, memo, diffusion, matrix, transparency, width, rowTransparency, counts);
+
+            rows[r].done.store(x + 1, std::memory_order_release);
         }
+
+        rowsDone++;
+
+        progress.setProgress(static_cast<unsigned int>(id), static_cast<unsigned int>(rowsDone));
     }
+
+    memoStats = memo.getStats();
 }
 
-void threadGenerateMapFunc(int id, size_t fromZ, size_t toZ, std::vector<const minecraft::FinalColor *> &result, const std::vector<minecraft::FinalColor> &colorSet, std::vector<colors::Color> &matrix, std::vector<bool> &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, threading::Progress &progress, std::vector<size_t> &counts)
+template <typename Method>
+void threadGenerateMapTilesFunc(int id, std::atomic<size_t> &nextTile, const GenerateBand &band, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, const colors::Color *matrix, const mapart::TransparencyMask &transparency, size_t width, bool preserveTransparency, mapart::ErrorDiffusionMode diffusionMode, threading::Progress &progress, const threading::CancellationToken &cancel, std::vector<size_t> &counts, PaletteMemoStats &memoStats)
 {
-    size_t closest;
-    vector<size_t> closest2;
-    double d1;
-    double d2;
+    PaletteMemo memo;
+    ErrorDiffusionBuffer diffusion; // Error buffer of the tile
+
+    // The band starts at the top of a map
+    size_t tilesX = (width + MAP_WIDTH - 1) / MAP_WIDTH;
+    size_t tilesZ = (band.toZ - band.fromZ + MAP_HEIGHT - 1) / MAP_HEIGHT;
+
+    size_t pixelsDone = 0;
 
-    // Compute data
-    for (size_t z = fromZ; z < toZ; z++)
+    while (!cancel.isCancelled())
     {
-        for (size_t x = 0; x < width; x++)
+        size_t t = nextTile.fetch_add(1);
+
+        if (t >= tilesX * tilesZ)
         {
-            size_t index = z * width + x;
+            break;
+        }
 
-            if (preserveTransparency && transparency[index])
-            {
-                result[index] = &(colorSet[0]); // Void
-                continue;
-            }
+        // Pixels of the map
+        size_t fromX = (t % tilesX) * MAP_WIDTH;
+        size_t fromZ = band.fromZ + (t / tilesX) * MAP_HEIGHT;
+        size_t toX = min(fromX + MAP_WIDTH, width);
+        size_t toZ = min(fromZ + MAP_HEIGHT, band.toZ);
+
+        // Pixels dithered into the error buffer (the map and its seams)
+        size_t regionFromX = fromX;
+        size_t regionFromZ = fromZ;
+        size_t regionToX = toX;
+
+        if (diffusionMode == ErrorDiffusionMode::TiledSeams)
+        {
+            regionFromX = fromX - min(fromX, static_cast<size_t>(TILE_SEAM_SIZE));
+            regionFromZ = fromZ - min(fromZ, static_cast<size_t>(TILE_SEAM_SIZE));
+            regionToX = min(toX + TILE_SEAM_RIGHT, width);
+        }
+
+        size_t regionW = regionToX - regionFromX;
+        size_t regionH = toZ - regionFromZ;
+
+        diffusion.init(regionW, regionH);
 
-            switch (ditheringMethod)
+        for (size_t z = 0; z < regionH; z++)
+        {
+            size_t imageZ = regionFromZ + z;
+
+            // Fully opaque rows do not check the transparency of each pixel
+            size_t rowIndex = (imageZ - band.matrixZ) * width;
+            size_t resultRowIndex = (imageZ - band.fromZ) * width; // Only valid inside the map
+            bool rowTransparency = preserveTransparency && transparency.countTransparent(rowIndex + regionFromX, rowIndex + regionToX) > 0;
+
+            for (size_t x = 0; x < regionW; x++)
             {
-            case DitheringMethod::Bayer44:
-                closest2 = find2ClosestColors(colorSet, matrix[index], colorDistanceAlgo, &d1, &d2);
-                if (((d1 * (BAYER_44_MATRIX_H * BAYER_44_MATRIX_W + 1)) / d2) > BAYER_44_MATRIX[x % BAYER_44_MATRIX_H][z % BAYER_44_MATRIX_W])
-                {
-                    result[index] = &(colorSet[closest2[1]]);
-                }
-                else
-                {
-                    result[index] = &(colorSet[closest2[0]]);
-                }
-                break;
-            case DitheringMethod::Bayer22:
-                closest2 = find2ClosestColors(colorSet, matrix[index], colorDistanceAlgo, &d1, &d2);
-                if (((d1 * (BAYER_22_MATRIX_H * BAYER_22_MATRIX_W + 1)) / d2) > BAYER_22_MATRIX[x % BAYER_22_MATRIX_H][z % BAYER_22_MATRIX_W])
-                {
-                    result[index] = &(colorSet[closest2[1]]);
-                }
-                else
-                {
-                    result[index] = &(colorSet[closest2[0]]);
-                }
-                break;
-            case DitheringMethod::Ordered33:
-                closest2 = find2ClosestColors(colorSet, matrix[index], colorDistanceAlgo, &d1, &d2);
-                if (((d1 * (ORDERED_33_MATRIX_H * ORDERED_33_MATRIX_W + 1)) / d2) > ORDERED_33_MATRIX[x % ORDERED_33_MATRIX_H][z % ORDERED_33_MATRIX_W])
+                size_t imageX = regionFromX + x;
+                size_t index = rowIndex + imageX;
+                bool inside = imageZ >= fromZ && imageX >= fromX && imageX < toX;
+
+                if (rowTransparency && transparency.isTransparent(index))
                 {
-                    result[index] = &(colorSet[closest2[1]]);
+                    if (inside)
+                    {
+                        result[resultRowIndex + imageX] = 0; // Void
+                    }
+                    diffusion.skipPixel(x, z);
+                    continue;
                 }
-                else
+
+                int32_t value[3];
+                colors::Color color = diffusion.getPixel(matrix[index], x, z, value);
+                size_t closest = findClosestColorMemo(paletteSearch, memo, color);
+
+                diffusion.diffuse<Method>(x, z, value, colorSet[closest].color);
+
+                if (inside)
                 {
-                    result[index] = &(colorSet[closest2[0]]);
+                    result[resultRowIndex + imageX] = static_cast<map_color_t>(closest);
+                    counts[colorSet[closest].baseColorIndex]++;
                 }
-                break;
-            case DitheringMethod::FloydSteinberg:
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
-                applyErrorDiffussion(matrix, width, height, matrix[index], colorSet[closest].color, x, z, FLOYD_STEINBERG_MATRIX, FLOYD_STEINBERG_DIVISOR);
-                break;
-            case DitheringMethod::MinAvgErr:
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
-                applyErrorDiffussion(matrix, width, height, matrix[index], colorSet[closest].color, x, z, MINAVGERR_MATRIX, MINAVGERR_DIVISOR);
-                break;
-            case DitheringMethod::Burkes:
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
-                applyErrorDiffussion(matrix, width, height, matrix[index], colorSet[closest].color, x, z, BURKES_MATRIX, BURKES_DIVISOR);
-                break;
-            case DitheringMethod::SierraLite:
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
-                applyErrorDiffussion(matrix, width, height, matrix[index], colorSet[closest].color, x, z, SIERRA_LITE_MATRIX, SIERRA_LITE_DIVISOR);
-                break;
-            case DitheringMethod::Stucki:
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
-                applyErrorDiffussion(matrix, width, height, matrix[index], colorSet[closest].color, x, z, STUCKI_MATRIX, STUCKI_DIVISOR);
-                break;
-            case DitheringMethod::Atkinson:
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
-                applyErrorDiffussion(matrix, width, height, matrix[index], colorSet[closest].color, x, z, ATKINSON_MATRIX, ATKINSON_DIVISOR);
-                break;
-            default:
-                // None (No dithering)
-                closest = findClosestColor(colorSet, matrix[index], colorDistanceAlgo);
-                result[index] = &(colorSet[closest]);
             }
-
-            counts[result[index]->baseColorIndex]++;
-        }
-        try
-        {
-            progress.setProgress(static_cast<unsigned int>(id), static_cast<unsigned int>(z - fromZ + 1));
-        }
-        catch (int)
-        {
-            return;
         }
+
+        pixelsDone += (toX - fromX) * (toZ - fromZ);
+
+        // Progress is measured in rows
+        progress.setProgress(static_cast<unsigned int>(id), static_cast<unsigned int>(pixelsDone / width));
     }
+
+    memoStats = memo.getStats();
 }
 
-std::vector<const minecraft::FinalColor *> mapart::generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const std::vector<bool> &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts)
+/**
+ * @brief  Generates the map art with a dithering method
+ * @note   Method is the description of the dithering method (see dithering.h)
+ * @param  &band: Rows to generate (all the rows of the image, or a band)
+ * @param  height: Height of the whole image
+ * @param  threadNum: Max number of threads (less threads are used for small images)
+ * @param  &scratch: Working memory. Stores the counts and memo stats of each thread
+ * @retval None
+ */
+template <typename Method>
+void generateMapThreads(const GenerateBand &band, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, const colors::Color *colorMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, MapArtScratch &scratch)
 {
-    std::vector<colors::Color> matrix(colorMatrix);     // Make a copy of colorMatrix to work with
-    std::vector<bool> transparencyMatrix(transparency); // Make a copy of transparency to work with
-    std::vector<const minecraft::FinalColor *> result(width * height);
+    bool wavefront = false;
+    bool tiled = false;
 
-    for (int j = 0; j < MAX_COLOR_GROUPS; j++)
+    size_t bandHeight = band.toZ - band.fromZ;
+
+    // Small images do not need all the threads
+    threadNum = max(min(threadNum, (width * bandHeight) / GENERATE_MIN_PIXELS_PER_THREAD), static_cast<size_t>(1));
+
+    // Error diffusion methods modify the next rows, so the rows are computed as a wavefront,
+    // unless the error is confined to each map
+    if constexpr (Method::kind == DitheringKind::ErrorDiffusion)
     {
-        counts[j] = 0;
+        if (diffusionMode == ErrorDiffusionMode::Tiled || diffusionMode == ErrorDiffusionMode::TiledSeams)
+        {
+            size_t tiles = ((width + MAP_WIDTH - 1) / MAP_WIDTH) * ((bandHeight + MAP_HEIGHT - 1) / MAP_HEIGHT);
+            threadNum = max(min(threadNum, tiles), static_cast<size_t>(1));
+            tiled = true;
+        }
+        else
+        {
+            threadNum = min(threadNum, max(bandHeight, static_cast<size_t>(1)));
+            wavefront = threadNum > 1;
+        }
     }
 
-    switch (ditheringMethod)
+    std::vector<std::vector<size_t>> &countParts = scratch.countParts;
+    std::vector<PaletteMemoStats> &memoStatsParts = scratch.memoStatsParts;
+
+    countParts.resize(threadNum);
+    memoStatsParts.resize(threadNum);
+
+    // Rows of each chunk (error diffusion needs the rows in order, so it is only chunked with 1 thread)
+    size_t chunkRows = max(GENERATE_CHUNK_PIXELS / max(width, static_cast<size_t>(1)), static_cast<size_t>(1));
+
+    std::atomic<size_t> nextChunk(0);
+    std::atomic<size_t> nextRow(0);
+    std::atomic<size_t> nextTile(0);
+
+    // Error buffer, shared by the rows (each tile has its own)
+    ErrorDiffusionBuffer &diffusion = scratch.diffusion;
+
+    // The error of the previous bands is kept (the rows of the buffer are of the whole image)
+    if (Method::kind == DitheringKind::ErrorDiffusion && !tiled && band.fromZ == 0)
     {
-    // These dithering methods won't support muti-threading due to race conditions
-    case DitheringMethod::FloydSteinberg:
-    case DitheringMethod::MinAvgErr:
-    case DitheringMethod::Burkes:
-    case DitheringMethod::SierraLite:
-    case DitheringMethod::Stucki:
-    case DitheringMethod::Atkinson:
-        threadNum = 1;
-        break;
+        diffusion.init(width, height);
     }
 
-    std::vector<std::thread> threads(threadNum);
-    std::vector<std::vector<size_t>> countParts(threadNum);
+    // Checked by the threads at every row (or map)
+    const threading::CancellationToken &cancel = progress.getCancellationToken();
+    std::vector<WavefrontRow> &rows = scratch.wavefrontRows;
 
-    size_t amountPerThread = height / threadNum;
+    if (wavefront)
+    {
+        if (rows.size() < bandHeight)
+        {
+            // Rows are atomic, so the vector is replaced instead of resized
+            std::vector<WavefrontRow> grown(bandHeight);
+            rows.swap(grown);
+        }
+
+        for (size_t r = 0; r < bandHeight; r++)
+        {
+            rows[r].done.store(0);
+        }
+    }
 
-    // Create threads
     for (size_t i = 0; i < threadNum; i++)
     {
         countParts[i].resize(MAX_COLOR_GROUPS);
@@ -306,25 +613,223 @@ std::vector<const minecraft::FinalColor *> mapart::generateMapArt(const std::vec
         {
             countParts[i][j] = 0;
         }
+    }
+
+    // Run one task per thread in the shared pool, and wait for them
+    threading::getThreadPool().run(threadNum, [&](size_t i) {
+        if constexpr (Method::kind == DitheringKind::ErrorDiffusion)
+        {
+            if (tiled)
+            {
+                threadGenerateMapTilesFunc<Method>(i, nextTile, band, result, colorSet, paletteSearch, colorMatrix, transparency, width, preserveTransparency, diffusionMode, progress, cancel, countParts[i], memoStatsParts[i]);
+                return;
+            }
+
+            if (wavefront)
+            {
+                threadGenerateMapWavefrontFunc<Method>(i, nextRow, rows, band, result, colorSet, paletteSearch, diffusion, colorMatrix, transparency, width, preserveTransparency, progress, cancel, countParts[i], memoStatsParts[i]);
+                return;
+            }
+        }
+
+        threadGenerateMapFunc<Method>(i, nextChunk, chunkRows, band, result, colorSet, paletteSearch, diffusion, colorMatrix, transparency, width, preserveTransparency, progress, cancel, countParts[i], memoStatsParts[i]);
+    });
+}
+
+/**
+ * @brief  Computes the L*ab colors of a part of the color matrix
+ * @note   Uses the exact conversion (cielab::rgbToLab), so the search gets the same
+ *         colors as without the plane. Images repeat colors a lot, so the conversions
+ *         are cached by color (direct mapped cache)
+ * @param  *colorMatrix: Colors
+ * @param  *labMatrix: Array to store the L*ab colors
+ * @param  n: Number of colors
+ * @retval None
+ */
+void computeLabMatrixPart(const colors::Color *colorMatrix, colors::Lab *labMatrix, size_t n)
+{
+    std::vector<uint32_t> keys(LAB_PLANE_CACHE_SIZE, 0xFFFFFFFF); // Not a valid RGB key
+    std::vector<colors::Lab> values(LAB_PLANE_CACHE_SIZE);
 
-        size_t startZ = i * amountPerThread;
-        size_t endZ = startZ + amountPerThread;
+    for (size_t i = 0; i < n; i++)
+    {
+        const colors::Color &c = colorMatrix[i];
+        uint32_t key = (static_cast<uint32_t>(c.red) << 16) | (static_cast<uint32_t>(c.green) << 8) | static_cast<uint32_t>(c.blue);
+        size_t slot = static_cast<size_t>((key * 2654435761u) >> 20) & (LAB_PLANE_CACHE_SIZE - 1);
 
-        if (i == threadNum - 1)
+        if (keys[slot] != key)
         {
-            // Last thread, get the rest
-            endZ = height;
+            keys[slot] = key;
+            cielab::rgbToLab(c, &values[slot]);
         }
-        threads[i] = std::thread(threadGenerateMapFunc, i, startZ, endZ, std::ref(result), std::ref(colorSet), std::ref(matrix), std::ref(transparencyMatrix), width, height, preserveTransparency, colorDistanceAlgo, ditheringMethod, std::ref(progress), std::ref(countParts[i]));
+
+        labMatrix[i] = values[slot];
     }
+}
 
-    // Wait for the threads
-    for (size_t i = 0; i < threadNum; i++)
+void mapart::computeLabMatrix(const colors::Color *colorMatrix, colors::Lab *labMatrix, size_t n, size_t threadNum)
+{
+    size_t maxThreads = n / LAB_PLANE_MIN_PIXELS_PER_THREAD;
+
+    if (threadNum > maxThreads)
+    {
+        threadNum = maxThreads;
+    }
+
+    if (threadNum <= 1)
+    {
+        computeLabMatrixPart(colorMatrix, labMatrix, n);
+        return;
+    }
+
+    size_t amountPerThread = n / threadNum;
+
+    threading::getThreadPool().run(threadNum, [&](size_t i) {
+        size_t start = i * amountPerThread;
+        size_t end = (i == threadNum - 1) ? n : (start + amountPerThread);
+
+        computeLabMatrixPart(colorMatrix + start, labMatrix + start, end - start);
+    });
+}
+
+std::vector<colors::Lab> mapart::computeLabMatrix(const std::vector<colors::Color> &colorMatrix, size_t threadNum)
+{
+    std::vector<colors::Lab> labMatrix(colorMatrix.size());
+
+    if (colorMatrix.size() > 0)
+    {
+        computeLabMatrix(&colorMatrix[0], &labMatrix[0], colorMatrix.size(), threadNum);
+    }
+
+    return labMatrix;
+}
+
+std::vector<map_color_t> mapart::generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts)
+{
+    std::vector<colors::Lab> labMatrix;
+    return generateMapArt(colorSet, colorMatrix, labMatrix, transparency, width, height, preserveTransparency, colorDistanceAlgo, ditheringMethod, ErrorDiffusionMode::Exact, threadNum, progress, counts, NULL);
+}
+
+std::vector<map_color_t> mapart::generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const std::vector<colors::Lab> &labMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts)
+{
+    return generateMapArt(colorSet, colorMatrix, labMatrix, transparency, width, height, preserveTransparency, colorDistanceAlgo, ditheringMethod, diffusionMode, threadNum, progress, counts, NULL);
+}
+
+std::vector<map_color_t> mapart::generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const std::vector<colors::Lab> &labMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts, mapart::PaletteMemoStats *memoStats)
+{
+    std::vector<map_color_t> result(width * height);
+    MapArtScratch scratch;
+
+    generateMapArt(colorSet, colorMatrix.data(), labMatrix.size() == width * height ? labMatrix.data() : NULL, transparency, width, height, preserveTransparency, colorDistanceAlgo, ditheringMethod, diffusionMode, threadNum, progress, scratch, result.data(), counts, memoStats);
+
+    return result;
+}
+
+/**
+ * @brief  Builds the closest color search structures
+ * @note
+ * @param  &paletteSearch: Search structures to build
+ * @param  pixels: Number of pixels of the image (the lookup table only pays off for big images)
+ * @retval None
+ */
+void buildPaletteSearch(PaletteSearch &paletteSearch, const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, size_t pixels, size_t threadNum)
+{
+    paletteSearch.useCompiled = (colorDistanceAlgo == ColorDistanceAlgorithm::Euclidean);
+
+    if (paletteSearch.useCompiled)
+    {
+        paletteSearch.compiled.build(colorSet, colorDistanceAlgo);
+    }
+    else
+    {
+        paletteSearch.index.build(colorSet, colorDistanceAlgo);
+    }
+
+    // Lookup table for the closest color, not used by the ordered dithering methods
+    switch (ditheringMethod)
+    {
+    case DitheringMethod::Bayer44:
+    case DitheringMethod::Bayer22:
+    case DitheringMethod::Bayer88:
+    case DitheringMethod::Bayer1616:
+    case DitheringMethod::Ordered33:
+    case DitheringMethod::BlueNoise:
+        break;
+    default:
+        // Loading a cached table is cheaper than building it, so it pays off for smaller images
+        if (pixels >= PALETTE_LUT_MIN_PIXELS_CACHED && loadCachedPaletteLookupTable(paletteSearch.lut, colorSet, colorDistanceAlgo))
+        {
+            break;
+        }
+
+        if (pixels >= (colorDistanceAlgo == ColorDistanceAlgorithm::DeltaE ? PALETTE_LUT_MIN_PIXELS_DELTA_E : PALETTE_LUT_MIN_PIXELS))
+        {
+            paletteSearch.lut.build(colorSet, colorDistanceAlgo, threadNum);
+            storeCachedPaletteLookupTable(paletteSearch.lut, colorSet, colorDistanceAlgo);
+        }
+    }
+
+    // The memo cache is not faster than the lookup table
+    paletteSearch.useMemo = !paletteSearch.lut.isBuilt();
+
+    paletteSearch.labMatrix = NULL;
+}
+
+/**
+ * @brief  Checks if the L*ab plane of the image is used
+ * @note   Only for the methods that search the colors of the original image with DeltaE
+ * @retval True if used
+ */
+bool usesLabMatrix(colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod)
+{
+    if (colorDistanceAlgo != ColorDistanceAlgorithm::DeltaE)
+    {
+        return false;
+    }
+
+    switch (ditheringMethod)
+    {
+    case DitheringMethod::None:
+    case DitheringMethod::Bayer44:
+    case DitheringMethod::Bayer22:
+    case DitheringMethod::Bayer88:
+    case DitheringMethod::Bayer1616:
+    case DitheringMethod::Ordered33:
+    case DitheringMethod::BlueNoise:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief  Generates the rows of a band, with the dithering method
+ * @note   Adds the counts and memo stats of the threads
+ * @param  *memoStats: Pointer to add the memo stats (can be NULL)
+ * @retval None
+ */
+void generateBand(const GenerateBand &band, map_color_t *result, const std::vector<minecraft::FinalColor> &colorSet, const PaletteSearch &paletteSearch, const colors::Color *colorMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, MapArtScratch &scratch, std::vector<size_t> &counts, mapart::PaletteMemoStats *memoStats)
+{
+    // The generation is compiled for each dithering method
+    dispatchDitheringMethod(ditheringMethod, [&](auto method) {
+        generateMapThreads<decltype(method)>(band, result, colorSet, paletteSearch, colorMatrix, transparency, width, height, preserveTransparency, diffusionMode, threadNum, progress, scratch);
+    });
+
+    for (size_t i = 0; i < scratch.countParts.size(); i++)
     {
-        threads[i].join();
         for (int j = 0; j < MAX_COLOR_GROUPS; j++)
         {
-            counts[j] += countParts[i][j];
+            counts[j] += scratch.countParts[i][j];
+        }
+    }
+
+    if (memoStats != NULL)
+    {
+        for (size_t i = 0; i < scratch.memoStatsParts.size(); i++)
+        {
+            memoStats->lookups += scratch.memoStatsParts[i].lookups;
+            memoStats->hits += scratch.memoStatsParts[i].hits;
+            memoStats->entries += scratch.memoStatsParts[i].entries;
         }
     }
 
@@ -332,6 +837,138 @@ std::vector<const minecraft::FinalColor *> mapart::generateMapArt(const std::vec
     {
         throw -1;
     }
+}
 
-    return result;
+void mapart::generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const colors::Color *colorMatrix, const colors::Lab *labMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, MapArtScratch &scratch, map_color_t *result, std::vector<size_t> &counts, mapart::PaletteMemoStats *memoStats)
+{
+    for (int j = 0; j < MAX_COLOR_GROUPS; j++)
+    {
+        counts[j] = 0;
+    }
+
+    if (memoStats != NULL)
+    {
+        memoStats->lookups = 0;
+        memoStats->hits = 0;
+        memoStats->entries = 0;
+    }
+
+    // Closest color search
+    PaletteSearch paletteSearch;
+    buildPaletteSearch(paletteSearch, colorSet, colorDistanceAlgo, ditheringMethod, width * height, threadNum);
+
+    // L*ab plane, for the methods that search the colors of the original image
+    if (usesLabMatrix(colorDistanceAlgo, ditheringMethod))
+    {
+        if (labMatrix != NULL)
+        {
+            paletteSearch.labMatrix = labMatrix;
+        }
+        else if (width * height > 0)
+        {
+            scratch.labMatrix.resize(width * height);
+            computeLabMatrix(colorMatrix, &scratch.labMatrix[0], width * height, threadNum);
+            paletteSearch.labMatrix = &scratch.labMatrix[0];
+        }
+    }
+
+    GenerateBand band;
+    band.fromZ = 0;
+    band.toZ = height;
+    band.matrixZ = 0;
+
+    generateBand(band, result, colorSet, paletteSearch, colorMatrix, transparency, width, height, preserveTransparency, ditheringMethod, diffusionMode, threadNum, progress, scratch, counts, memoStats);
+}
+
+MapArtStream::MapArtStream()
+{
+    width = 0;
+    height = 0;
+    preserveTransparency = false;
+    colorDistanceAlgo = ColorDistanceAlgorithm::Euclidean;
+    ditheringMethod = DitheringMethod::None;
+    diffusionMode = ErrorDiffusionMode::Exact;
+    threadNum = 1;
+    nextZ = 0;
+
+    memoStats.lookups = 0;
+    memoStats.hits = 0;
+    memoStats.entries = 0;
+}
+
+void MapArtStream::init(const std::vector<minecraft::FinalColor> &colorSet, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum)
+{
+    this->colorSet = colorSet;
+    this->width = width;
+    this->height = height;
+    this->preserveTransparency = preserveTransparency;
+    this->colorDistanceAlgo = colorDistanceAlgo;
+    this->ditheringMethod = ditheringMethod;
+    this->diffusionMode = diffusionMode;
+    this->threadNum = threadNum;
+
+    nextZ = 0;
+
+    memoStats.lookups = 0;
+    memoStats.hits = 0;
+    memoStats.entries = 0;
+
+    // Built once for the whole image
+    buildPaletteSearch(paletteSearch, colorSet, colorDistanceAlgo, ditheringMethod, width * height, threadNum);
+}
+
+size_t MapArtStream::getContextRows() const
+{
+    if (diffusionMode == ErrorDiffusionMode::TiledSeams)
+    {
+        return TILE_SEAM_SIZE;
+    }
+
+    return 0;
+}
+
+void MapArtStream::generateRows(const colors::Color *colorMatrix, const mapart::TransparencyMask &transparency, size_t matrixZ, size_t fromZ, size_t toZ, threading::Progress &progress, map_color_t *result, std::vector<size_t> &counts)
+{
+    // Errors of the caller, not a cancellation (-1)
+    if (fromZ != nextZ || toZ < fromZ || toZ > height)
+    {
+        throw std::logic_error("MapArtStream: bands must be generated in order");
+    }
+
+    if (matrixZ > fromZ || fromZ - matrixZ < min(fromZ, getContextRows()))
+    {
+        throw std::logic_error("MapArtStream: missing context rows above the band");
+    }
+
+    // The error buffers of the tiled modes are per map, so a band can not split a map
+    if ((diffusionMode == ErrorDiffusionMode::Tiled || diffusionMode == ErrorDiffusionMode::TiledSeams) && (fromZ % MAP_HEIGHT != 0 || (toZ % MAP_HEIGHT != 0 && toZ != height)))
+    {
+        throw std::logic_error("MapArtStream: bands must be whole rows of maps with tiled error diffusion");
+    }
+
+    size_t matrixPixels = (toZ - matrixZ) * width;
+
+    // L*ab plane of the rows of the band
+    paletteSearch.labMatrix = NULL;
+
+    if (usesLabMatrix(colorDistanceAlgo, ditheringMethod) && matrixPixels > 0)
+    {
+        scratch.labMatrix.resize(matrixPixels);
+        computeLabMatrix(colorMatrix, &scratch.labMatrix[0], matrixPixels, threadNum);
+        paletteSearch.labMatrix = &scratch.labMatrix[0];
+    }
+
+    GenerateBand band;
+    band.fromZ = fromZ;
+    band.toZ = toZ;
+    band.matrixZ = matrixZ;
+
+    generateBand(band, result, colorSet, paletteSearch, colorMatrix, transparency, width, height, preserveTransparency, ditheringMethod, diffusionMode, threadNum, progress, scratch, counts, &memoStats);
+
+    nextZ = toZ;
+}
+
+mapart::PaletteMemoStats MapArtStream::getMemoStats() const
+{
+    return memoStats;
 }
@@ -24,22 +24,215 @@
 #pragma once
 
 #include "common.h"
+#include "transparency_mask.h"
 #include "../threads/progress.h"
+#include "palette_memo.h"
+#include "error_diffusion.h"
+#include "palette_search.h"
+
+#include <atomic>
 
 namespace mapart
 {
+    /**
+     * @brief  Progress of a row in the wavefront
+     * @note   Aligned to its own cache line, so threads do not invalidate each other's rows
+     * @retval None
+     */
+    struct alignas(64) WavefrontRow
+    {
+        // Number of pixels of the row already computed
+        std::atomic<size_t> done;
+    };
+
+    /**
+     * @brief  Working memory of the map art generation
+     * @note   The buffers only grow, so generating images of the same size again
+     *         (like the preview) does not allocate them again.
+     *         Error diffusion keeps a ring of rows (see ErrorDiffusionBuffer),
+     *         never a copy of the image.
+     *         Do not share it between generations running at the same time.
+     * @retval None
+     */
+    struct MapArtScratch
+    {
+        ErrorDiffusionBuffer diffusion;
+        std::vector<WavefrontRow> wavefrontRows;
+        std::vector<colors::Lab> labMatrix; // Only used if the L*ab plane is not provided
+        std::vector<std::vector<size_t>> countParts;
+        std::vector<PaletteMemoStats> memoStatsParts;
+    };
+
     /**
      * @brief  Generates map art
-     * @note
+     * @note   Error diffusion is exact (see ErrorDiffusionMode)
+     * @param  &colorSet: Color set
+     * @param  &colorMatrix: Original color matrix
+     * @param  &transparency: Transparency matrix
+     * @param  width: Image width
+     * @param  height: Image height
+     * @param  preserveTransparency: True to preserve transparency
+     * @param  colorDistanceAlgo: Color distance algorithm
+     * @param  ditheringMethod: Dithering method
+     * @retval Map color of each pixel (index in the color set)
+     */
+    std::vector<map_color_t> generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts);
+
+    /**
+     * @brief  Generates map art, with the L*ab plane of the image already computed
+     * @note   The L*ab plane is only used with DeltaE, for no dithering and
+     *         ordered dithering. Error diffusion is done in RGB.
+     *         If it is empty, it is computed when required.
      * @param  &colorSet: Color set
      * @param  &colorMatrix: Original color matrix
+     * @param  &labMatrix: L*ab plane of the color matrix (see computeLabMatrix)
      * @param  &transparency: Transparency matrix
      * @param  width: Image width
      * @param  height: Image height
      * @param  preserveTransparency: True to preserve transparency
      * @param  colorDistanceAlgo: Color distance algorithm
      * @param  ditheringMethod: Dithering method
-     * @retval Array of final colors
+     * @param  diffusionMode: Scope of the error diffusion (only for error diffusion methods)
+     * @retval Map color of each pixel (index in the color set)
+     */
+    std::vector<map_color_t> generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const std::vector<colors::Lab> &labMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts);
+
+    /**
+     * @brief  Generates map art, collecting statistics
+     * @note   See the other overloads
+     * @param  &colorSet: Color set
+     * @param  &colorMatrix: Original color matrix
+     * @param  &labMatrix: L*ab plane of the color matrix (can be empty)
+     * @param  &transparency: Transparency matrix
+     * @param  width: Image width
+     * @param  height: Image height
+     * @param  preserveTransparency: True to preserve transparency
+     * @param  colorDistanceAlgo: Color distance algorithm
+     * @param  ditheringMethod: Dithering method
+     * @param  diffusionMode: Scope of the error diffusion (only for error diffusion methods)
+     * @param  memoStats: Pointer to store the statistics of the memo cache (can be NULL).
+     *                    Entries are the sum of the per-thread caches.
+     * @retval Map color of each pixel (index in the color set)
+     */
+    std::vector<map_color_t> generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const std::vector<colors::Lab> &labMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts, mapart::PaletteMemoStats *memoStats);
+
+    /**
+     * @brief  Generates map art into a buffer of the caller
+     * @note   Does not copy the image nor allocate the result. Reuse the scratch
+     *         and the result buffer across calls to avoid allocations.
+     *         See the other overloads.
+     * @param  &colorSet: Color set
+     * @param  *colorMatrix: Original color matrix (width * height colors)
+     * @param  *labMatrix: L*ab plane of the color matrix (NULL to compute it when required)
+     * @param  &transparency: Transparency matrix
+     * @param  width: Image width
+     * @param  height: Image height
+     * @param  preserveTransparency: True to preserve transparency
+     * @param  colorDistanceAlgo: Color distance algorithm
+     * @param  ditheringMethod: Dithering method
+     * @param  diffusionMode: Scope of the error diffusion (only for error diffusion methods)
+     * @param  &scratch: Working memory
+     * @param  *result: Buffer to store the map color of each pixel (width * height)
+     * @param  memoStats: Pointer to store the statistics of the memo cache (can be NULL)
+     * @retval None
+     */
+    void generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const colors::Color *colorMatrix, const colors::Lab *labMatrix, const mapart::TransparencyMask &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum, threading::Progress &progress, MapArtScratch &scratch, map_color_t *result, std::vector<size_t> &counts, mapart::PaletteMemoStats *memoStats);
+
+    /**
+     * @brief  Generates map art by bands of rows, without the whole image in memory
+     * @note   The bands are generated in order from the top, and the result is the same
+     *         as generating the whole image. With the tiled error diffusion modes,
+     *         bands must start at the top of a map (rows of maps).
+     *         Each band needs the rows above it given by getContextRows.
+     * @retval None
+     */
+    class MapArtStream
+    {
+    public:
+        MapArtStream();
+
+        /**
+         * @brief  Initializes the generation of an image
+         * @note   Builds the closest color search structures, once for all the bands
+         * @param  &colorSet: Color set
+         * @param  width: Image width
+         * @param  height: Image height
+         * @param  preserveTransparency: True to preserve transparency
+         * @param  colorDistanceAlgo: Color distance algorithm
+         * @param  ditheringMethod: Dithering method
+         * @param  diffusionMode: Scope of the error diffusion (only for error diffusion methods)
+         * @param  threadNum: Max number of threads
+         * @retval None
+         */
+        void init(const std::vector<minecraft::FinalColor> &colorSet, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, mapart::ErrorDiffusionMode diffusionMode, size_t threadNum);
+
+        /**
+         * @brief  Gets the number of rows above a band needed to generate it
+         * @note   The seams of ErrorDiffusionMode::TiledSeams
+         * @retval Number of rows
+         */
+        size_t getContextRows() const;
+
+        /**
+         * @brief  Generates the next band of rows
+         * @note   Throws -1 if the task is cancelled.
+         *         Throws std::logic_error if the band is not the next one, lacks its context rows,
+         *         or (with ErrorDiffusionMode::Tiled and TiledSeams) does not start and end at the border of a map
+         * @param  *colorMatrix: Colors of the rows from matrixZ to toZ
+         * @param  &transparency: Transparency of the rows from matrixZ to toZ
+         * @param  matrixZ: First row of the color matrix (fromZ - getContextRows(), or 0)
+         * @param  fromZ: First row of the band
+         * @param  toZ: Row after the last one of the band
+         * @param  &progress: Progress (in rows of the band)
+         * @param  *result: Buffer to store the map colors of the band ((toZ - fromZ) * width)
+         * @param  &counts: Counts of each color, the counts of the band are added
+         * @retval None
+         */
+        void generateRows(const colors::Color *colorMatrix, const mapart::TransparencyMask &transparency, size_t matrixZ, size_t fromZ, size_t toZ, threading::Progress &progress, map_color_t *result, std::vector<size_t> &counts);
+
+        /**
+         * @brief  Gets the statistics of the memo cache
+         * @note   Sum of all the bands
+         * @retval The statistics
+         */
+        mapart::PaletteMemoStats getMemoStats() const;
+
+    private:
+        std::vector<minecraft::FinalColor> colorSet;
+        size_t width;
+        size_t height;
+        bool preserveTransparency;
+        colors::ColorDistanceAlgorithm colorDistanceAlgo;
+        mapart::DitheringMethod ditheringMethod;
+        mapart::ErrorDiffusionMode diffusionMode;
+        size_t threadNum;
+
+        PaletteSearch paletteSearch;
+        MapArtScratch scratch;
+        mapart::PaletteMemoStats memoStats;
+
+        // First row of the next band
+        size_t nextZ;
+    };
+
+    /**
+     * @brief  Computes the L*ab plane of a color matrix
+     * @note   Same values as cielab::rgbToLab for each color (not the batch conversion),
+     *         so the colors found with the plane are the same as without it
+     * @param  *colorMatrix: Colors
+     * @param  *labMatrix: Array to store the L*ab plane (same size)
+     * @param  n: Number of colors
+     * @param  threadNum: Number of threads
+     * @retval None
+     */
+    void computeLabMatrix(const colors::Color *colorMatrix, colors::Lab *labMatrix, size_t n, size_t threadNum);
+
+    /**
+     * @brief  Computes the L*ab plane of a color matrix
+     * @note   Compute it once and reuse it for every generation of the same image
+     * @param  &colorMatrix: Color matrix
+     * @param  threadNum: Number of threads
+     * @retval L*ab plane
      */
-    std::vector<const minecraft::FinalColor *> generateMapArt(const std::vector<minecraft::FinalColor> &colorSet, const std::vector<colors::Color> &colorMatrix, const std::vector<bool> &transparency, size_t width, size_t height, bool preserveTransparency, colors::ColorDistanceAlgorithm colorDistanceAlgo, mapart::DitheringMethod ditheringMethod, size_t threadNum, threading::Progress &progress, std::vector<size_t> &counts);
+    std::vector<colors::Lab> computeLabMatrix(const std::vector<colors::Color> &colorMatrix, size_t threadNum);
 }
@@ -22,64 +22,83 @@
  */
 
 #include "map_image.h"
+#include <algorithm>
 
 using namespace std;
 using namespace colors;
 using namespace mapart;
 
-ImageColorMatrix mapart::loadColorMatrixFromImageAndPad(wxImage &image, colors::Color background, unsigned char transparencyTolerance, int *padWidth, int *padHeight)
+void mapart::getPaddedImageSize(wxImage &image, int *padWidth, int *padHeight)
+{
+    int width = image.GetSize().GetWidth();
+    int height = image.GetSize().GetHeight();
+
+    *padWidth = width + ((width % MAP_WIDTH > 0) ? (MAP_WIDTH - (width % MAP_WIDTH)) : 0);
+    *padHeight = height + ((height % MAP_HEIGHT > 0) ? (MAP_HEIGHT - (height % MAP_HEIGHT)) : 0 );
+}
+
+void mapart::loadColorMatrixRowsFromImage(wxImage &image, colors::Color background, unsigned char transparencyTolerance, int fromZ, int toZ, ImageColorMatrix &result)
 {
     int width = image.GetSize().GetWidth();
     int height = image.GetSize().GetHeight();
 
-    int finalWidth = width + ((width % MAP_WIDTH > 0) ? (MAP_WIDTH - (width % MAP_WIDTH)) : 0);
-    int finalHeight = height + ((height % MAP_HEIGHT > 0) ? (MAP_HEIGHT - (height % MAP_HEIGHT)) : 0 );
-    size_t size = finalWidth * finalHeight;
+    int finalWidth;
+    int finalHeight;
+    getPaddedImageSize(image, &finalWidth, &finalHeight);
+
+    size_t size = static_cast<size_t>(finalWidth) * (toZ - fromZ);
 
     int imagePosX = (finalWidth - width) / 2;
     int imagePosZ = (finalHeight - height) / 2;
 
-    vector<Color> resultColors(size);
-    vector<bool> resultTransparency(size);
+    result.colors.resize(size);
+    result.transparency.init(size, true);
+    result.lab.clear();
 
     // Init colors to white
     for (size_t i = 0; i < size; i++)
     {
-        resultColors[i].red = background.red;
-        resultColors[i].green = background.green;
-        resultColors[i].blue = background.blue;
-
-        resultTransparency[i] = true;
+        result.colors[i].red = background.red;
+        result.colors[i].green = background.green;
+        result.colors[i].blue = background.blue;
+        result.colors[i].unused = 0;
     }
 
+    // Rows of the image inside the band
+    int imageFromZ = max(fromZ - imagePosZ, 0);
+    int imageToZ = min(toZ - imagePosZ, height);
+
     // Iterate
     unsigned char *rawData = image.GetData();
     unsigned char *alphaData = image.GetAlpha();
-    for (int z = 0; z < height; z++)
+    for (int z = imageFromZ; z < imageToZ; z++)
     {
         for (int x = 0; x < width; x++)
         {
-            int indexImage = (z * width + x) * 3;
-            int indexFinal = (imagePosZ + z) * finalWidth + (imagePosX + x);
+            size_t indexImage = (static_cast<size_t>(z) * width + x) * 3;
+            size_t indexFinal = static_cast<size_t>(imagePosZ + z - fromZ) * finalWidth + (imagePosX + x);
 
-            resultColors[indexFinal].red = rawData[indexImage];
-            resultColors[indexFinal].green = rawData[indexImage + 1];
-            resultColors[indexFinal].blue = rawData[indexImage + 2];
+            result.colors[indexFinal].red = rawData[indexImage];
+            result.colors[indexFinal].green = rawData[indexImage + 1];
+            result.colors[indexFinal].blue = rawData[indexImage + 2];
 
             if (alphaData != NULL) {
-                resultColors[indexFinal] = colors::bendColor(resultColors[indexFinal], alphaData[z * width + x], background);
-                resultTransparency[indexFinal] = alphaData[z * width + x] < transparencyTolerance;
+                unsigned char alpha = alphaData[static_cast<size_t>(z) * width + x];
+                result.colors[indexFinal] = colors::bendColor(result.colors[indexFinal], alpha, background);
+                result.transparency.setTransparent(indexFinal, alpha < transparencyTolerance);
             } else {
-                resultTransparency[indexFinal] = false;
+                result.transparency.setTransparent(indexFinal, false);
             }
         }
     }
+}
+
+ImageColorMatrix mapart::loadColorMatrixFromImageAndPad(wxImage &image, colors::Color background, unsigned char transparencyTolerance, int *padWidth, int *padHeight)
+{
+    getPaddedImageSize(image, padWidth, padHeight);
 
-    *padWidth = finalWidth;
-    *padHeight = finalHeight;
+    ImageColorMatrix result;
+    loadColorMatrixRowsFromImage(image, background, transparencyTolerance, 0, *padHeight, result);
 
-    return ImageColorMatrix{
-        resultColors,
-        resultTransparency,
-    };
+    return result;
 }
@@ -32,6 +32,7 @@
 #include <vector>
 
 #include "map_art.h"
+#include "transparency_mask.h"
 
 namespace mapart {
     /**
@@ -41,10 +42,35 @@ namespace mapart {
      */
     struct ImageColorMatrix {
         std::vector<colors::Color> colors;
-        std::vector<bool> transparency;
+        TransparencyMask transparency;
+        std::vector<colors::Lab> lab; // L*ab colors, only computed when required
     };
 
 
+    /**
+     * @brief  Gets the size of an image padded to whole maps
+     * @note   
+     * @param  &image: Image
+     * @param  padWidth: By reference, to store matrix width
+     * @param  padHeight: By reference, to store matrix height
+     * @retval None
+     */
+    void getPaddedImageSize(wxImage &image, int * padWidth, int * padHeight);
+
+    /**
+     * @brief  Loads some rows of the padded color matrix from image
+     * @note   To process the image by bands (see MapArtStream).
+     *         Same colors as the rows of loadColorMatrixFromImageAndPad
+     * @param  &image: Image
+     * @param  background: Background color
+     * @param  transparencyTolerance: Transparency tolerance
+     * @param  fromZ: First row of the padded matrix
+     * @param  toZ: Row after the last one
+     * @param  &result: Matrix to store the rows (its memory is reused)
+     * @retval None
+     */
+    void loadColorMatrixRowsFromImage(wxImage &image, colors::Color background, unsigned char transparencyTolerance, int fromZ, int toZ, ImageColorMatrix &result);
+
     /**
      * @brief  Loads color matrix from image
      * @note   
@@ -61,11 +61,11 @@ void MaterialsList::setSupportBlockMaterialName(std::string supportBlockMaterial
     this->supportBlockMaterialName = supportBlockMaterialName;
 }
 
-void MaterialsList::addBlocks(std::vector<mapart::MapBuildingBlock> &buildingBlocks)
+void MaterialsList::addBlocks(const mapart::MapBuildPlan &buildingBlocks)
 {
-    for (size_t i = 0; i < buildingBlocks.size(); i++)
+    for (const mapart::MapBuildingBlock block : buildingBlocks)
     {
-        const minecraft::BlockDescription *blockPtr = buildingBlocks[i].block_ptr;
+        const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
         if (blockPtr == NULL)
         {
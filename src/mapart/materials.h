@@ -23,7 +23,7 @@
 
 #pragma once
 
-#include "common.h"
+#include "build_plan.h"
 
 namespace mapart
 {
@@ -58,7 +58,7 @@ namespace mapart
 
         void setSupportBlockMaterialName(std::string supportBlockMaterialName);
 
-        void addBlocks(std::vector<mapart::MapBuildingBlock> &buildingBlocks);
+        void addBlocks(const mapart::MapBuildPlan &buildingBlocks);
 
         std::string toString();
     };
@@ -0,0 +1,166 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "palette_cache.h"
+#include "../tools/fs.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+using namespace std;
+using namespace colors;
+using namespace mapart;
+
+std::mutex paletteCacheMutex;
+std::string paletteCacheFolder;
+
+/**
+ * @brief  Gets the path of the cache file of a table
+ * @note
+ * @param  &folder: Cache folder
+ * @param  key: Key of the table
+ * @retval The path
+ */
+std::string getPaletteCacheFile(const std::string &folder, uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "lut-%016llx.bin", static_cast<unsigned long long>(key));
+    return (fs::path(folder) / fs::path(name)).string();
+}
+
+/**
+ * @brief  Removes the oldest tables of the cache folder
+ * @note   Keeps PALETTE_CACHE_MAX_FILES tables
+ * @param  &folder: Cache folder
+ * @retval None
+ */
+void prunePaletteCacheFolder(const std::string &folder)
+{
+    std::error_code ec;
+    vector<pair<fs::file_time_type, fs::path>> files;
+
+    for (fs::directory_iterator it(fs::path(folder), ec); !ec && it != fs::directory_iterator(); it.increment(ec))
+    {
+        std::string name = it->path().filename().string();
+
+        if (name.rfind("lut-", 0) != 0)
+        {
+            continue;
+        }
+
+        std::error_code timeEc;
+        fs::file_time_type time = fs::last_write_time(it->path(), timeEc);
+
+        if (!timeEc)
+        {
+            files.push_back(make_pair(time, it->path()));
+        }
+    }
+
+    if (files.size() <= PALETTE_CACHE_MAX_FILES)
+    {
+        return;
+    }
+
+    sort(files.begin(), files.end());
+
+    for (size_t i = 0; i < files.size() - PALETTE_CACHE_MAX_FILES; i++)
+    {
+        fs::remove(files[i].second, ec);
+    }
+}
+
+void mapart::setPaletteCacheFolder(const std::string &folder)
+{
+    std::lock_guard<std::mutex> lock(paletteCacheMutex);
+    paletteCacheFolder = folder;
+}
+
+std::string mapart::getPaletteCacheFolder()
+{
+    std::lock_guard<std::mutex> lock(paletteCacheMutex);
+    return paletteCacheFolder;
+}
+
+bool mapart::loadCachedPaletteLookupTable(PaletteLookupTable &lut, const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo)
+{
+    std::string folder = getPaletteCacheFolder();
+
+    if (folder.size() == 0)
+    {
+        return false;
+    }
+
+    uint64_t key = PaletteLookupTable::computeKey(colorSet, algo);
+    std::string path = getPaletteCacheFile(folder, key);
+
+    std::error_code ec;
+
+    if (!fs::exists(fs::path(path), ec))
+    {
+        return false;
+    }
+
+    if (lut.loadFromFile(colorSet, algo, path, key))
+    {
+        return true;
+    }
+
+    // Corrupted or from another version, remove it so it is built again
+    fs::remove(fs::path(path), ec);
+
+    return false;
+}
+
+bool mapart::storeCachedPaletteLookupTable(const PaletteLookupTable &lut, const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo)
+{
+    std::string folder = getPaletteCacheFolder();
+
+    if (folder.size() == 0)
+    {
+        return false;
+    }
+
+    std::error_code ec;
+
+    if (!fs::exists(fs::path(folder), ec))
+    {
+        fs::create_directories(fs::path(folder), ec);
+
+        if (ec)
+        {
+            return false;
+        }
+    }
+
+    uint64_t key = PaletteLookupTable::computeKey(colorSet, algo);
+
+    if (!lut.saveToFile(getPaletteCacheFile(folder, key), key))
+    {
+        return false;
+    }
+
+    prunePaletteCacheFolder(folder);
+
+    return true;
+}
@@ -0,0 +1,69 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "palette_lut.h"
+
+#include <string>
+
+// Max number of tables kept in the cache folder. The oldest ones are removed
+#define PALETTE_CACHE_MAX_FILES (32)
+
+namespace mapart
+{
+    /**
+     * @brief  Sets the folder of the palette lookup table cache
+     * @note   Set it once at startup. An empty string disables the cache (default)
+     * @param  &folder: Path to the folder (created when required)
+     * @retval None
+     */
+    void setPaletteCacheFolder(const std::string &folder);
+
+    /**
+     * @brief  Gets the folder of the palette lookup table cache
+     * @note
+     * @retval Path to the folder, empty if the cache is disabled
+     */
+    std::string getPaletteCacheFolder();
+
+    /**
+     * @brief  Loads a lookup table from the cache
+     * @note   The table file is mapped into memory. Invalid files are removed.
+     * @param  &lut: Table to load
+     * @param  &colorSet: Color set
+     * @param  algo: Color distance algorithm
+     * @retval True if loaded, false if not found in the cache
+     */
+    bool loadCachedPaletteLookupTable(PaletteLookupTable &lut, const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo);
+
+    /**
+     * @brief  Stores a lookup table in the cache
+     * @note
+     * @param  &lut: Table (built with the color set and algorithm)
+     * @param  &colorSet: Color set
+     * @param  algo: Color distance algorithm
+     * @retval True if stored
+     */
+    bool storeCachedPaletteLookupTable(const PaletteLookupTable &lut, const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo);
+}
@@ -0,0 +1,383 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "palette_index.h"
+#include "../colors/cielab.h"
+#include <algorithm>
+#include <limits>
+
+#define PALETTE_INDEX_LEAF (3)
+
+using namespace std;
+using namespace colors;
+using namespace mapart;
+
+/**
+ * @brief  Squared distance between 2 points
+ * @note   Same operations as colors::colorDistance, to get the same rounding
+ * @param  a: First point
+ * @param  b: Second point
+ * @retval The distance
+ */
+inline double pointDistance(const double a[3], const double b[3])
+{
+    double d0 = a[0] - b[0];
+    double d1 = a[1] - b[1];
+    double d2 = a[2] - b[2];
+    return (d0 * d0) + (d1 * d1) + (d2 * d2);
+}
+
+/**
+ * @brief  Compares 2 results of a query
+ * @note   Lowest index wins on tie, like the linear search
+ * @retval True if (d, i) is better than (bestD, bestI)
+ */
+inline bool isCloser(double d, size_t i, double bestD, size_t bestI)
+{
+    return d < bestD || (d == bestD && i < bestI);
+}
+
+/*
+ * Note about pruning: the children of a branch are split by a coordinate (split).
+ * Floating point subtraction is monotonic, so for any point on the other side
+ * of the split, the computed difference in that axis is at least (query - split)
+ * in absolute value, and so its computed distance is not lower than that squared.
+ * This makes the pruning exact.
+ */
+
+void searchClosest(const vector<PaletteIndexNode> &nodes, const vector<PaletteIndexPoint> &points, uint32_t nodeIndex, const double query[3], double &bestD, size_t &bestI)
+{
+    const PaletteIndexNode &node = nodes[nodeIndex];
+
+    if (node.axis == PALETTE_INDEX_LEAF)
+    {
+        for (size_t j = node.first; j < node.second; j++)
+        {
+            double d = pointDistance(query, points[j].coords);
+            if (isCloser(d, points[j].index, bestD, bestI))
+            {
+                bestD = d;
+                bestI = points[j].index;
+            }
+        }
+        return;
+    }
+
+    double diff = query[node.axis] - node.split;
+
+    if (diff < 0)
+    {
+        searchClosest(nodes, points, node.first, query, bestD, bestI);
+        if (diff * diff <= bestD)
+        {
+            searchClosest(nodes, points, node.second, query, bestD, bestI);
+        }
+    }
+    else
+    {
+        searchClosest(nodes, points, node.second, query, bestD, bestI);
+        if (diff * diff <= bestD)
+        {
+            searchClosest(nodes, points, node.first, query, bestD, bestI);
+        }
+    }
+}
+
+void search2Closest(const vector<PaletteIndexNode> &nodes, const vector<PaletteIndexPoint> &points, uint32_t nodeIndex, const double query[3], double &bestD1, size_t &bestI1, double &bestD2, size_t &bestI2)
+{
+    const PaletteIndexNode &node = nodes[nodeIndex];
+
+    if (node.axis == PALETTE_INDEX_LEAF)
+    {
+        for (size_t j = node.first; j < node.second; j++)
+        {
+            double d = pointDistance(query, points[j].coords);
+            size_t i = points[j].index;
+
+            if (isCloser(d, i, bestD1, bestI1))
+            {
+                bestD2 = bestD1;
+                bestI2 = bestI1;
+                bestD1 = d;
+                bestI1 = i;
+            }
+            else if (isCloser(d, i, bestD2, bestI2))
+            {
+                bestD2 = d;
+                bestI2 = i;
+            }
+        }
+        return;
+    }
+
+    double diff = query[node.axis] - node.split;
+
+    if (diff < 0)
+    {
+        search2Closest(nodes, points, node.first, query, bestD1, bestI1, bestD2, bestI2);
+        if (diff * diff <= bestD2)
+        {
+            search2Closest(nodes, points, node.second, query, bestD1, bestI1, bestD2, bestI2);
+        }
+    }
+    else
+    {
+        search2Closest(nodes, points, node.second, query, bestD1, bestI1, bestD2, bestI2);
+        if (diff * diff <= bestD2)
+        {
+            search2Closest(nodes, points, node.first, query, bestD1, bestI1, bestD2, bestI2);
+        }
+    }
+}
+
+PaletteIndex::PaletteIndex()
+{
+    algo = ColorDistanceAlgorithm::Euclidean;
+}
+
+void PaletteIndex::build(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo)
+{
+    this->algo = algo;
+
+    points.clear();
+    nodes.clear();
+
+    size_t size = colorSet.size();
+
+    // Start with i = 4 to skip all NONE blocks
+    for (size_t i = 4; i < size; i++)
+    {
+        if (!colorSet[i].enabled)
+        {
+            continue;
+        }
+
+        PaletteIndexPoint point;
+
+        if (algo == ColorDistanceAlgorithm::DeltaE)
+        {
+            point.coords[0] = colorSet[i].lab.L;
+            point.coords[1] = colorSet[i].lab.a;
+            point.coords[2] = colorSet[i].lab.b;
+        }
+        else
+        {
+            point.coords[0] = colorSet[i].color.red;
+            point.coords[1] = colorSet[i].color.green;
+            point.coords[2] = colorSet[i].color.blue;
+        }
+
+        point.index = i;
+
+        points.push_back(point);
+    }
+
+    if (points.size() > 0)
+    {
+        buildNode(0, points.size());
+    }
+}
+
+uint32_t PaletteIndex::buildNode(size_t from, size_t to)
+{
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(PaletteIndexNode());
+
+    if (to - from <= PALETTE_INDEX_LEAF_SIZE)
+    {
+        nodes[nodeIndex].axis = PALETTE_INDEX_LEAF;
+        nodes[nodeIndex].split = 0;
+        nodes[nodeIndex].first = static_cast<uint32_t>(from);
+        nodes[nodeIndex].second = static_cast<uint32_t>(to);
+        return nodeIndex;
+    }
+
+    // Split by the axis with the biggest spread
+    uint32_t axis = 0;
+    double bestSpread = -1;
+
+    for (uint32_t c = 0; c < 3; c++)
+    {
+        double minC = points[from].coords[c];
+        double maxC = points[from].coords[c];
+
+        for (size_t j = from + 1; j < to; j++)
+        {
+            minC = min(minC, points[j].coords[c]);
+            maxC = max(maxC, points[j].coords[c]);
+        }
+
+        if (maxC - minC > bestSpread)
+        {
+            bestSpread = maxC - minC;
+            axis = c;
+        }
+    }
+
+    size_t mid = from + (to - from) / 2;
+
+    nth_element(points.begin() + from, points.begin() + mid, points.begin() + to, [axis](const PaletteIndexPoint &a, const PaletteIndexPoint &b) {
+        return a.coords[axis] < b.coords[axis];
+    });
+
+    double split = points[mid].coords[axis];
+
+    uint32_t first = buildNode(from, mid);
+    uint32_t second = buildNode(mid, to);
+
+    nodes[nodeIndex].axis = axis;
+    nodes[nodeIndex].split = split;
+    nodes[nodeIndex].first = first;
+    nodes[nodeIndex].second = second;
+
+    return nodeIndex;
+}
+
+size_t PaletteIndex::size() const
+{
+    return points.size();
+}
+
+void PaletteIndex::queryPoint(colors::Color color, double query[3]) const
+{
+    if (algo == ColorDistanceAlgorithm::DeltaE)
+    {
+        Lab lab;
+        cielab::rgbToLab(color, &lab);
+        query[0] = lab.L;
+        query[1] = lab.a;
+        query[2] = lab.b;
+    }
+    else
+    {
+        query[0] = color.red;
+        query[1] = color.green;
+        query[2] = color.blue;
+    }
+}
+
+size_t PaletteIndex::findClosestPoint(const double query[3]) const
+{
+    if (points.size() == 0)
+    {
+        return 0;
+    }
+
+    double bestD = numeric_limits<double>::infinity();
+    size_t bestI = numeric_limits<size_t>::max();
+
+    searchClosest(nodes, points, 0, query, bestD, bestI);
+
+    return bestI;
+}
+
+minecraft::ClosestColorPair PaletteIndex::findClosestPointPair(const double query[3]) const
+{
+    minecraft::ClosestColorPair pair;
+
+    if (points.size() == 0)
+    {
+        pair.first = 0;
+        pair.second = 0;
+        pair.distFirst = 0;
+        pair.distSecond = 0;
+        return pair;
+    }
+
+    double bestD1 = numeric_limits<double>::infinity();
+    size_t bestI1 = numeric_limits<size_t>::max();
+    double bestD2 = numeric_limits<double>::infinity();
+    size_t bestI2 = numeric_limits<size_t>::max();
+
+    search2Closest(nodes, points, 0, query, bestD1, bestI1, bestD2, bestI2);
+
+    if (points.size() == 1)
+    {
+        // Only one color
+        bestD2 = bestD1;
+        bestI2 = bestI1;
+    }
+
+    pair.first = bestI1;
+    pair.second = bestI2;
+    pair.distFirst = bestD1;
+    pair.distSecond = bestD2;
+
+    return pair;
+}
+
+size_t PaletteIndex::findClosestColor(colors::Color color) const
+{
+    double query[3];
+    queryPoint(color, query);
+    return findClosestPoint(query);
+}
+
+size_t PaletteIndex::findClosestColor(const colors::Lab &lab) const
+{
+    double query[3] = {lab.L, lab.a, lab.b};
+    return findClosestPoint(query);
+}
+
+std::vector<size_t> PaletteIndex::find2ClosestColors(colors::Color color, double *distFirst, double *distSecond) const
+{
+    minecraft::ClosestColorPair pair = findClosestColorPair(color);
+
+    *distFirst = pair.distFirst;
+    *distSecond = pair.distSecond;
+
+    std::vector<size_t> v(2);
+
+    v[0] = pair.first;
+    v[1] = pair.second;
+
+    return v;
+}
+
+std::vector<size_t> PaletteIndex::find2ClosestColors(const colors::Lab &lab, double *distFirst, double *distSecond) const
+{
+    minecraft::ClosestColorPair pair = findClosestColorPair(lab);
+
+    *distFirst = pair.distFirst;
+    *distSecond = pair.distSecond;
+
+    std::vector<size_t> v(2);
+
+    v[0] = pair.first;
+    v[1] = pair.second;
+
+    return v;
+}
+
+minecraft::ClosestColorPair PaletteIndex::findClosestColorPair(colors::Color color) const
+{
+    double query[3];
+    queryPoint(color, query);
+    return findClosestPointPair(query);
+}
+
+minecraft::ClosestColorPair PaletteIndex::findClosestColorPair(const colors::Lab &lab) const
+{
+    double query[3] = {lab.L, lab.a, lab.b};
+    return findClosestPointPair(query);
+}
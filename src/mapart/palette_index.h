@@ -0,0 +1,154 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <cstdint>
+
+// Max number of colors in a leaf of the tree
+#define PALETTE_INDEX_LEAF_SIZE (6)
+
+namespace mapart
+{
+    /**
+     * @brief  Point of the palette index
+     * @note   Coordinates are RGB or L*ab, depending on the algorithm
+     * @retval None
+     */
+    struct PaletteIndexPoint
+    {
+        double coords[3];
+        size_t index;
+    };
+
+    /**
+     * @brief  Node of the palette index (k-d tree)
+     * @note   Leafs have axis = 3 and point to a range of points.
+     *         Branches point to their two children.
+     * @retval None
+     */
+    struct PaletteIndexNode
+    {
+        uint32_t axis;
+        double split;
+        uint32_t first;
+        uint32_t second;
+    };
+
+    /**
+     * @brief  Spatial index (k-d tree) of the enabled colors of a color set
+     * @note   Queries are exact and return the same colors as a linear search
+     *         (in case of tie, the lowest index is returned).
+     *         Build it again after changing the enabled colors.
+     * @retval None
+     */
+    class PaletteIndex
+    {
+    public:
+        PaletteIndex();
+
+        /**
+         * @brief  Builds the index
+         * @note
+         * @param  &colorSet: Color set (only enabled colors are used)
+         * @param  algo: Color distance algorithm
+         * @retval None
+         */
+        void build(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo);
+
+        /**
+         * @brief  Gets the number of colors in the index
+         * @note
+         * @retval Number of enabled colors
+         */
+        size_t size() const;
+
+        /**
+         * @brief  Finds the closest color
+         * @note
+         * @param  color: Original color (RGB)
+         * @retval The index inside the color set (0 if there are no enabled colors)
+         */
+        size_t findClosestColor(colors::Color color) const;
+
+        /**
+         * @brief  Finds the closest color
+         * @note   Only for DeltaE
+         * @param  &lab: Original color (L*ab)
+         * @retval The index inside the color set (0 if there are no enabled colors)
+         */
+        size_t findClosestColor(const colors::Lab &lab) const;
+
+        /**
+         * @brief  Finds the 2 closest colors
+         * @note   If there is only one enabled color, it is returned twice
+         * @param  color: Original color (RGB)
+         * @param  distFirst: Pointer to store the distance of the closest color
+         * @param  distSecond: Pointer to store the distance of the second closest color
+         * @retval Vector with the 2 indexes inside the color set
+         */
+        std::vector<size_t> find2ClosestColors(colors::Color color, double *distFirst, double *distSecond) const;
+
+        /**
+         * @brief  Finds the 2 closest colors
+         * @note   Only for DeltaE. If there is only one enabled color, it is returned twice
+         * @param  &lab: Original color (L*ab)
+         * @param  distFirst: Pointer to store the distance of the closest color
+         * @param  distSecond: Pointer to store the distance of the second closest color
+         * @retval Vector with the 2 indexes inside the color set
+         */
+        std::vector<size_t> find2ClosestColors(const colors::Lab &lab, double *distFirst, double *distSecond) const;
+
+        /**
+         * @brief  Finds the 2 closest colors
+         * @note   Same as find2ClosestColors, without allocating memory
+         * @param  color: Original color (RGB)
+         * @retval The 2 closest colors and their distances
+         */
+        minecraft::ClosestColorPair findClosestColorPair(colors::Color color) const;
+
+        /**
+         * @brief  Finds the 2 closest colors
+         * @note   Only for DeltaE. Same as find2ClosestColors, without allocating memory
+         * @param  &lab: Original color (L*ab)
+         * @retval The 2 closest colors and their distances
+         */
+        minecraft::ClosestColorPair findClosestColorPair(const colors::Lab &lab) const;
+
+    private:
+        colors::ColorDistanceAlgorithm algo;
+
+        std::vector<PaletteIndexPoint> points;
+        std::vector<PaletteIndexNode> nodes;
+
+        uint32_t buildNode(size_t from, size_t to);
+
+        void queryPoint(colors::Color color, double query[3]) const;
+
+        size_t findClosestPoint(const double query[3]) const;
+
+        minecraft::ClosestColorPair findClosestPointPair(const double query[3]) const;
+    };
+}
@@ -0,0 +1,690 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "palette_lut.h"
+#include "../colors/cielab.h"
+#include "../tools/fs.h"
+#include "../threads/thread_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+// Margin added to the L*ab bounds of a cell, to absorb rounding differences of pow()
+#define LAB_BOUNDS_MARGIN (1e-6)
+
+// Relative margin for the L*ab distance comparisons
+#define LAB_DISTANCE_MARGIN (1e-9)
+
+// Magic bytes at the start of the table files
+#define PALETTE_LUT_FILE_MAGIC "MCMAPLUT"
+
+using namespace std;
+using namespace colors;
+using namespace mapart;
+
+/**
+ * @brief  Header of the table files
+ * @note   Followed by the cells (uint32_t) and the candidates (uint16_t).
+ *         Values are stored in the native byte order.
+ * @retval None
+ */
+struct PaletteLookupTableFileHeader
+{
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t algo;
+    uint64_t key;
+    uint32_t lutBits;
+    uint32_t colorCount;
+    uint64_t cellsCount;
+    uint64_t candidatesCount;
+    uint64_t checksum;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(PaletteLookupTableFileHeader) == 64, "Unexpected size of the table file header");
+
+/**
+ * @brief  FNV-1a hash of a block of memory
+ * @note
+ * @param  data: Pointer to the data
+ * @param  size: Size in bytes
+ * @param  hash: Initial hash (to hash several blocks)
+ * @retval The hash
+ */
+inline uint64_t hashBytes(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+#define HASH_BYTES_INITIAL (14695981039346656037ULL)
+
+/**
+ * @brief  Checksum of a block of memory
+ * @note   FNV-1a over 64 bit words (and the remaining bytes), faster than
+ *         hashBytes for the table contents
+ * @param  data: Pointer to the data
+ * @param  size: Size in bytes
+ * @param  hash: Initial hash (to hash several blocks)
+ * @retval The checksum
+ */
+inline uint64_t checksumBytes(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    size_t words = size / sizeof(uint64_t);
+
+    for (size_t i = 0; i < words; i++)
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+        hash ^= word;
+        hash *= 1099511628211ULL;
+        hash ^= hash >> 32;
+    }
+
+    return hashBytes(bytes + words * sizeof(uint64_t), size - words * sizeof(uint64_t), hash);
+}
+
+/**
+ * @brief  Axis aligned box in color space (RGB or L*ab)
+ * @note
+ * @retval None
+ */
+struct ColorBox
+{
+    double min[3];
+    double max[3];
+};
+
+inline double boxMinDistance(const ColorBox &box, const double point[3])
+{
+    double result = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        double d = 0;
+        if (point[c] < box.min[c])
+        {
+            d = box.min[c] - point[c];
+        }
+        else if (point[c] > box.max[c])
+        {
+            d = point[c] - box.max[c];
+        }
+        result += d * d;
+    }
+    return result;
+}
+
+inline double boxMaxDistance(const ColorBox &box, const double point[3])
+{
+    double result = 0;
+    for (int c = 0; c < 3; c++)
+    {
+        double d = max(point[c] - box.min[c], box.max[c] - point[c]);
+        result += d * d;
+    }
+    return result;
+}
+
+/**
+ * @brief  Computes the L*ab bounds of a cell of the RGB cube
+ * @note   X, Y and Z grow with each RGB component, so the bounds are reached
+ *         in the corners of the cell. The same conversion code is used to
+ *         get the same rounding as the real conversion.
+ * @param  low: Lowest RGB corner
+ * @param  high: Highest RGB corner
+ * @retval The box
+ */
+ColorBox labBoundsOfCell(Color low, Color high)
+{
+    XYZ xyzLow;
+    XYZ xyzHigh;
+
+    cielab::rgbToXYZ(low, &xyzLow);
+    cielab::rgbToXYZ(high, &xyzHigh);
+
+    XYZ mix;
+    Lab labA;
+    Lab labB;
+    Lab labC;
+    Lab labD;
+
+    // Min L, min b
+    mix.x = xyzLow.x;
+    mix.y = xyzLow.y;
+    mix.z = xyzHigh.z;
+    cielab::xyzToLab(&mix, &labA);
+
+    // Max L, max b
+    mix.x = xyzHigh.x;
+    mix.y = xyzHigh.y;
+    mix.z = xyzLow.z;
+    cielab::xyzToLab(&mix, &labB);
+
+    // Min a
+    mix.x = xyzLow.x;
+    mix.y = xyzHigh.y;
+    cielab::xyzToLab(&mix, &labC);
+
+    // Max a
+    mix.x = xyzHigh.x;
+    mix.y = xyzLow.y;
+    cielab::xyzToLab(&mix, &labD);
+
+    ColorBox box;
+
+    box.min[0] = labA.L - LAB_BOUNDS_MARGIN;
+    box.max[0] = labB.L + LAB_BOUNDS_MARGIN;
+    box.min[1] = labC.a - LAB_BOUNDS_MARGIN;
+    box.max[1] = labD.a + LAB_BOUNDS_MARGIN;
+    box.min[2] = labA.b - LAB_BOUNDS_MARGIN;
+    box.max[2] = labB.b + LAB_BOUNDS_MARGIN;
+
+    return box;
+}
+
+void threadBuildPaletteLookupTable(size_t fromRed, size_t toRed, std::vector<uint32_t> &cells, std::vector<uint16_t> &candidates, const std::vector<size_t> &enabledIndexes, const std::vector<double> &points, colors::ColorDistanceAlgorithm algo)
+{
+    size_t enabledCount = enabledIndexes.size();
+    vector<double> minDistances(enabledCount);
+
+    for (size_t r = fromRed; r < toRed; r++)
+    {
+        for (size_t g = 0; g < PALETTE_LUT_SIDE; g++)
+        {
+            for (size_t b = 0; b < PALETTE_LUT_SIDE; b++)
+            {
+                size_t cellIndex = (r << (2 * PALETTE_LUT_BITS)) | (g << PALETTE_LUT_BITS) | b;
+
+                if (enabledCount == 0)
+                {
+                    cells[cellIndex] = 0;
+                    continue;
+                }
+
+                Color low;
+                low.red = static_cast<unsigned char>(r * PALETTE_LUT_CELL_SIZE);
+                low.green = static_cast<unsigned char>(g * PALETTE_LUT_CELL_SIZE);
+                low.blue = static_cast<unsigned char>(b * PALETTE_LUT_CELL_SIZE);
+
+                Color high;
+                high.red = static_cast<unsigned char>(low.red + PALETTE_LUT_CELL_SIZE - 1);
+                high.green = static_cast<unsigned char>(low.green + PALETTE_LUT_CELL_SIZE - 1);
+                high.blue = static_cast<unsigned char>(low.blue + PALETTE_LUT_CELL_SIZE - 1);
+
+                ColorBox box;
+
+                if (algo == ColorDistanceAlgorithm::DeltaE)
+                {
+                    box = labBoundsOfCell(low, high);
+                }
+                else
+                {
+                    box.min[0] = low.red;
+                    box.min[1] = low.green;
+                    box.min[2] = low.blue;
+                    box.max[0] = high.red;
+                    box.max[1] = high.green;
+                    box.max[2] = high.blue;
+                }
+
+                // The closest color of any point of the cell is nearer than the
+                // smallest max distance, so any color with a bigger min distance is discarded
+                double bestMaxDistance = 0;
+
+                for (size_t i = 0; i < enabledCount; i++)
+                {
+                    minDistances[i] = boxMinDistance(box, &points[i * 3]);
+                    double maxDistance = boxMaxDistance(box, &points[i * 3]);
+
+                    if (i == 0 || maxDistance < bestMaxDistance)
+                    {
+                        bestMaxDistance = maxDistance;
+                    }
+                }
+
+                if (algo == ColorDistanceAlgorithm::DeltaE)
+                {
+                    bestMaxDistance += bestMaxDistance * LAB_DISTANCE_MARGIN + LAB_DISTANCE_MARGIN;
+                }
+
+                size_t candidatesCount = 0;
+                size_t firstCandidate = 0;
+
+                for (size_t i = 0; i < enabledCount; i++)
+                {
+                    if (minDistances[i] <= bestMaxDistance)
+                    {
+                        if (candidatesCount == 0)
+                        {
+                            firstCandidate = enabledIndexes[i];
+                        }
+                        candidatesCount++;
+                    }
+                }
+
+                if (candidatesCount == 1)
+                {
+                    cells[cellIndex] = static_cast<uint32_t>(firstCandidate);
+                    continue;
+                }
+
+                // Ambiguous: store the list of candidates (size first), ordered by index
+                cells[cellIndex] = PALETTE_LUT_AMBIGUOUS | static_cast<uint32_t>(candidates.size());
+                candidates.push_back(static_cast<uint16_t>(candidatesCount));
+
+                for (size_t i = 0; i < enabledCount; i++)
+                {
+                    if (minDistances[i] <= bestMaxDistance)
+                    {
+                        candidates.push_back(static_cast<uint16_t>(enabledIndexes[i]));
+                    }
+                }
+            }
+        }
+    }
+}
+
+PaletteLookupTable::PaletteLookupTable()
+{
+    built = false;
+    algo = ColorDistanceAlgorithm::Euclidean;
+    cellsData = NULL;
+    candidatesData = NULL;
+}
+
+bool PaletteLookupTable::isBuilt() const
+{
+    return built;
+}
+
+void PaletteLookupTable::build(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo, size_t threadNum)
+{
+    this->algo = algo;
+
+    size_t size = colorSet.size();
+
+    paletteColors.resize(size);
+    paletteLab.resize(size);
+
+    vector<size_t> enabledIndexes;
+    vector<double> points;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        paletteColors[i] = colorSet[i].color;
+        paletteLab[i] = colorSet[i].lab;
+
+        if (i < 4 || !colorSet[i].enabled)
+        {
+            // Skip all NONE blocks and the disabled colors
+            continue;
+        }
+
+        enabledIndexes.push_back(i);
+
+        if (algo == ColorDistanceAlgorithm::DeltaE)
+        {
+            points.push_back(colorSet[i].lab.L);
+            points.push_back(colorSet[i].lab.a);
+            points.push_back(colorSet[i].lab.b);
+        }
+        else
+        {
+            points.push_back(colorSet[i].color.red);
+            points.push_back(colorSet[i].color.green);
+            points.push_back(colorSet[i].color.blue);
+        }
+    }
+
+    cells.resize(PALETTE_LUT_CELLS);
+    candidates.clear();
+
+    threadNum = max((size_t)1, min(threadNum, (size_t)PALETTE_LUT_SIDE));
+
+    std::vector<std::vector<uint16_t>> candidatesParts(threadNum);
+
+    size_t amountPerThread = PALETTE_LUT_SIDE / threadNum;
+
+    threading::getThreadPool().run(threadNum, [&](size_t i) {
+        size_t startRed = i * amountPerThread;
+        size_t endRed = startRed + amountPerThread;
+
+        if (i == threadNum - 1)
+        {
+            // Last thread, get the rest
+            endRed = PALETTE_LUT_SIDE;
+        }
+
+        threadBuildPaletteLookupTable(startRed, endRed, cells, candidatesParts[i], enabledIndexes, points, algo);
+    });
+
+    // Join the candidate lists
+    for (size_t i = 0; i < threadNum; i++)
+    {
+        uint32_t offset = static_cast<uint32_t>(candidates.size());
+
+        if (offset > 0)
+        {
+            size_t startCell = (i * amountPerThread) << (2 * PALETTE_LUT_BITS);
+            size_t endCell = (i == threadNum - 1) ? PALETTE_LUT_CELLS : (((i + 1) * amountPerThread) << (2 * PALETTE_LUT_BITS));
+
+            for (size_t j = startCell; j < endCell; j++)
+            {
+                if (cells[j] & PALETTE_LUT_AMBIGUOUS)
+                {
+                    cells[j] += offset;
+                }
+            }
+        }
+
+        candidates.insert(candidates.end(), candidatesParts[i].begin(), candidatesParts[i].end());
+    }
+
+    mappedFile.reset();
+    cellsData = cells.data();
+    candidatesData = candidates.data();
+
+    built = true;
+}
+
+uint64_t PaletteLookupTable::computeKey(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo)
+{
+    uint64_t hash = HASH_BYTES_INITIAL;
+
+    uint32_t params[4];
+    params[0] = PALETTE_LUT_FILE_VERSION;
+    params[1] = PALETTE_LUT_BITS;
+    params[2] = static_cast<uint32_t>(algo);
+    params[3] = static_cast<uint32_t>(colorSet.size());
+
+    hash = hashBytes(params, sizeof(params), hash);
+
+    for (size_t i = 0; i < colorSet.size(); i++)
+    {
+        unsigned char rgbe[4];
+        rgbe[0] = colorSet[i].color.red;
+        rgbe[1] = colorSet[i].color.green;
+        rgbe[2] = colorSet[i].color.blue;
+        rgbe[3] = colorSet[i].enabled ? 1 : 0;
+
+        double lab[3];
+        lab[0] = colorSet[i].lab.L;
+        lab[1] = colorSet[i].lab.a;
+        lab[2] = colorSet[i].lab.b;
+
+        hash = hashBytes(rgbe, sizeof(rgbe), hash);
+        hash = hashBytes(lab, sizeof(lab), hash);
+    }
+
+    return hash;
+}
+
+bool PaletteLookupTable::saveToFile(const std::string &path, uint64_t key) const
+{
+    if (!built || mappedFile)
+    {
+        // Only built tables can be saved
+        return false;
+    }
+
+    size_t candidatesCount = candidates.size();
+
+    PaletteLookupTableFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PALETTE_LUT_FILE_MAGIC, sizeof(header.magic));
+    header.formatVersion = PALETTE_LUT_FILE_VERSION;
+    header.algo = static_cast<uint32_t>(algo);
+    header.key = key;
+    header.lutBits = PALETTE_LUT_BITS;
+    header.colorCount = static_cast<uint32_t>(paletteColors.size());
+    header.cellsCount = cells.size();
+    header.candidatesCount = candidatesCount;
+
+    uint64_t checksum = HASH_BYTES_INITIAL;
+    checksum = checksumBytes(cells.data(), cells.size() * sizeof(uint32_t), checksum);
+    checksum = checksumBytes(candidates.data(), candidatesCount * sizeof(uint16_t), checksum);
+    header.checksum = checksum;
+
+    // Unique temporary name, in case of several processes writing the same table
+    size_t unique = std::hash<std::thread::id>()(std::this_thread::get_id()) ^ static_cast<size_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::string tmpPath = path + ".tmp" + to_string(unique);
+
+    {
+        ofstream file(tmpPath, ios::out | ios::binary | ios::trunc);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(cells.data()), cells.size() * sizeof(uint32_t));
+        file.write(reinterpret_cast<const char *>(candidates.data()), candidatesCount * sizeof(uint16_t));
+        file.close();
+
+        if (!file)
+        {
+            std::error_code ec;
+            fs::remove(fs::path(tmpPath), ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(fs::path(tmpPath), fs::path(path), ec);
+
+    if (ec)
+    {
+        fs::remove(fs::path(tmpPath), ec);
+        return false;
+    }
+
+    return true;
+}
+
+bool PaletteLookupTable::loadFromFile(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo, const std::string &path, uint64_t key)
+{
+    std::unique_ptr<tools::MappedFile> file(new tools::MappedFile());
+
+    if (!file->open(path) || file->size() < sizeof(PaletteLookupTableFileHeader))
+    {
+        return false;
+    }
+
+    PaletteLookupTableFileHeader header;
+    memcpy(&header, file->data(), sizeof(header));
+
+    // Check the header
+    if (memcmp(header.magic, PALETTE_LUT_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.formatVersion != PALETTE_LUT_FILE_VERSION ||
+        header.algo != static_cast<uint32_t>(algo) ||
+        header.key != key ||
+        header.lutBits != PALETTE_LUT_BITS ||
+        header.colorCount != colorSet.size() ||
+        header.cellsCount != PALETTE_LUT_CELLS ||
+        header.candidatesCount > (file->size() / sizeof(uint16_t)))
+    {
+        return false;
+    }
+
+    size_t cellsSize = static_cast<size_t>(header.cellsCount) * sizeof(uint32_t);
+    size_t candidatesSize = static_cast<size_t>(header.candidatesCount) * sizeof(uint16_t);
+
+    if (file->size() != sizeof(header) + cellsSize + candidatesSize)
+    {
+        return false;
+    }
+
+    const uint32_t *fileCells = reinterpret_cast<const uint32_t *>(file->data() + sizeof(header));
+    const uint16_t *fileCandidates = reinterpret_cast<const uint16_t *>(file->data() + sizeof(header) + cellsSize);
+
+    // Check the contents
+    uint64_t checksum = HASH_BYTES_INITIAL;
+    checksum = checksumBytes(fileCells, cellsSize, checksum);
+    checksum = checksumBytes(fileCandidates, candidatesSize, checksum);
+
+    if (checksum != header.checksum)
+    {
+        return false;
+    }
+
+    // Check every index, so a bad file can never read out of bounds
+    size_t colorCount = colorSet.size();
+    size_t candidatesCount = static_cast<size_t>(header.candidatesCount);
+
+    for (size_t i = 0; i < PALETTE_LUT_CELLS; i++)
+    {
+        uint32_t cell = fileCells[i];
+
+        if (!(cell & PALETTE_LUT_AMBIGUOUS))
+        {
+            if (cell >= colorCount)
+            {
+                return false;
+            }
+            continue;
+        }
+
+        size_t offset = cell & (~PALETTE_LUT_AMBIGUOUS);
+
+        if (offset >= candidatesCount || fileCandidates[offset] == 0 || offset + 1 + fileCandidates[offset] > candidatesCount)
+        {
+            return false;
+        }
+
+        for (size_t j = 0; j < fileCandidates[offset]; j++)
+        {
+            if (fileCandidates[offset + 1 + j] >= colorCount)
+            {
+                return false;
+            }
+        }
+    }
+
+    // Valid, use it
+    this->algo = algo;
+
+    paletteColors.resize(colorCount);
+    paletteLab.resize(colorCount);
+
+    for (size_t i = 0; i < colorCount; i++)
+    {
+        paletteColors[i] = colorSet[i].color;
+        paletteLab[i] = colorSet[i].lab;
+    }
+
+    cells.clear();
+    candidates.clear();
+
+    cellsData = fileCells;
+    candidatesData = fileCandidates;
+    mappedFile = std::move(file);
+
+    built = true;
+
+    return true;
+}
+
+size_t PaletteLookupTable::getAmbiguousCellsCount() const
+{
+    size_t count = 0;
+
+    if (!built)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < PALETTE_LUT_CELLS; i++)
+    {
+        if (cellsData[i] & PALETTE_LUT_AMBIGUOUS)
+        {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+size_t PaletteLookupTable::refineClosestColor(const colors::Lab &lab, uint32_t candidatesOffset) const
+{
+    size_t count = candidatesData[candidatesOffset];
+    const uint16_t *list = &candidatesData[candidatesOffset + 1];
+
+    double distance = 0;
+    size_t result = 0;
+
+    for (size_t j = 0; j < count; j++)
+    {
+        size_t i = list[j];
+        double d = colorDistance(&lab, &(paletteLab[i]));
+        if (j == 0 || distance > d)
+        {
+            distance = d;
+            result = i;
+        }
+    }
+
+    return result;
+}
+
+size_t PaletteLookupTable::refineClosestColor(colors::Color color, uint32_t candidatesOffset) const
+{
+    size_t count = candidatesData[candidatesOffset];
+    const uint16_t *list = &candidatesData[candidatesOffset + 1];
+
+    double distance = 0;
+    size_t result = 0;
+
+    colors::Lab colorALab;
+
+    if (algo == ColorDistanceAlgorithm::DeltaE)
+    {
+        cielab::rgbToLab(color, &colorALab);
+    }
+
+    // Same comparison as minecraft::findClosestColor (candidates are sorted by index)
+    for (size_t j = 0; j < count; j++)
+    {
+        size_t i = list[j];
+        double d = (algo == ColorDistanceAlgorithm::DeltaE) ? colorDistance(&colorALab, &(paletteLab[i])) : colorDistance(paletteColors[i], color);
+        if (j == 0 || distance > d)
+        {
+            distance = d;
+            result = i;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,189 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+#include "../tools/mapped_file.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#define PALETTE_LUT_BITS (6)
+#define PALETTE_LUT_SIDE (1 << PALETTE_LUT_BITS)
+#define PALETTE_LUT_CELL_SIZE (256 >> PALETTE_LUT_BITS)
+#define PALETTE_LUT_CELLS (PALETTE_LUT_SIDE * PALETTE_LUT_SIDE * PALETTE_LUT_SIDE)
+
+#define PALETTE_LUT_AMBIGUOUS (0x80000000u)
+
+// Version of the file format. Change it when the format or the table contents change
+#define PALETTE_LUT_FILE_VERSION (1)
+
+// Images smaller than this are matched faster with the exhaustive search than building the table
+#define PALETTE_LUT_MIN_PIXELS (PALETTE_LUT_CELLS * 2)
+
+// Same for DeltaE, where building the table is slower
+#define PALETTE_LUT_MIN_PIXELS_DELTA_E (PALETTE_LUT_CELLS * 8)
+
+// Images smaller than this are matched faster with the exhaustive search than loading a cached table
+#define PALETTE_LUT_MIN_PIXELS_CACHED (PALETTE_LUT_CELLS / 4)
+
+namespace mapart
+{
+    /**
+     * @brief  RGB to palette lookup table
+     * @note   The RGB cube is split in cells of PALETTE_LUT_CELL_SIZE^3 colors.
+     *         Cells where a single palette color is the closest one for every
+     *         RGB value inside store that color. The rest of the cells (ambiguous)
+     *         store the list of colors that can be the closest one, and the
+     *         lookup is refined with an exact search over that list.
+     *         The results are the same as minecraft::findClosestColor.
+     * @retval None
+     */
+    class PaletteLookupTable
+    {
+    public:
+        PaletteLookupTable();
+
+        /**
+         * @brief  Builds the table
+         * @note
+         * @param  &colorSet: Color set (only enabled colors are used)
+         * @param  algo: Color distance algorithm
+         * @param  threadNum: Number of threads to use
+         * @retval None
+         */
+        void build(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo, size_t threadNum);
+
+        /**
+         * @brief  Checks if the table was built
+         * @note
+         * @retval True if built
+         */
+        bool isBuilt() const;
+
+        /**
+         * @brief  Computes the key that identifies the table of a color set
+         * @note   Hash of the colors (RGB and L*ab), the enabled colors,
+         *         the algorithm and the file format version
+         * @param  &colorSet: Color set
+         * @param  algo: Color distance algorithm
+         * @retval The key
+         */
+        static uint64_t computeKey(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo);
+
+        /**
+         * @brief  Saves the table to a file
+         * @note   Written to a temporary file first and then renamed,
+         *         so readers never see a partial file
+         * @param  &path: Path to the file
+         * @param  key: Key of the table (see computeKey)
+         * @retval True if success
+         */
+        bool saveToFile(const std::string &path, uint64_t key) const;
+
+        /**
+         * @brief  Loads the table from a file, mapping it into memory
+         * @note   The file is checked (header, key, size, checksum and contents).
+         *         If the file is not valid, the table is not modified.
+         * @param  &colorSet: Color set (must be the one used to build the table)
+         * @param  algo: Color distance algorithm
+         * @param  &path: Path to the file
+         * @param  key: Expected key (see computeKey)
+         * @retval True if loaded, false if the file is missing or not valid
+         */
+        bool loadFromFile(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo, const std::string &path, uint64_t key);
+
+        /**
+         * @brief  Finds the closest color
+         * @note
+         * @param  color: Original color (RGB)
+         * @retval The index inside the color set
+         */
+        inline size_t findClosestColor(colors::Color color) const
+        {
+            uint32_t cell = cellsData[cellIndex(color)];
+
+            if (cell & PALETTE_LUT_AMBIGUOUS)
+            {
+                return refineClosestColor(color, cell & (~PALETTE_LUT_AMBIGUOUS));
+            }
+
+            return cell;
+        }
+
+        /**
+         * @brief  Finds the closest color, with the L*ab color already computed
+         * @note   Only for DeltaE
+         * @param  color: Original color (RGB)
+         * @param  &lab: Original color (L*ab)
+         * @retval The index inside the color set
+         */
+        inline size_t findClosestColor(colors::Color color, const colors::Lab &lab) const
+        {
+            uint32_t cell = cellsData[cellIndex(color)];
+
+            if (cell & PALETTE_LUT_AMBIGUOUS)
+            {
+                return refineClosestColor(lab, cell & (~PALETTE_LUT_AMBIGUOUS));
+            }
+
+            return cell;
+        }
+
+        /**
+         * @brief  Gets the number of cells that require an exact search
+         * @note
+         * @retval Number of ambiguous cells
+         */
+        size_t getAmbiguousCellsCount() const;
+
+    private:
+        bool built;
+        colors::ColorDistanceAlgorithm algo;
+
+        std::vector<colors::Color> paletteColors;
+        std::vector<colors::Lab> paletteLab;
+
+        // Built table
+        std::vector<uint32_t> cells;
+        std::vector<uint16_t> candidates;
+
+        // Table loaded from a file
+        std::unique_ptr<tools::MappedFile> mappedFile;
+
+        // Table in use (built or mapped)
+        const uint32_t *cellsData;
+        const uint16_t *candidatesData;
+
+        inline static size_t cellIndex(colors::Color color)
+        {
+            return (static_cast<size_t>(color.red >> (8 - PALETTE_LUT_BITS)) << (2 * PALETTE_LUT_BITS)) | (static_cast<size_t>(color.green >> (8 - PALETTE_LUT_BITS)) << PALETTE_LUT_BITS) | static_cast<size_t>(color.blue >> (8 - PALETTE_LUT_BITS));
+        }
+
+        size_t refineClosestColor(colors::Color color, uint32_t candidatesOffset) const;
+
+        size_t refineClosestColor(const colors::Lab &lab, uint32_t candidatesOffset) const;
+    };
+}
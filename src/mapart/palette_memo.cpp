@@ -0,0 +1,168 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "palette_memo.h"
+
+using namespace std;
+using namespace colors;
+using namespace mapart;
+
+PaletteMemo::PaletteMemo()
+{
+    bits = PALETTE_MEMO_INITIAL_BITS;
+    mask = (1u << bits) - 1;
+    table.resize(static_cast<size_t>(1) << bits);
+
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        table[i].key = 0;
+    }
+
+    enabled = true;
+
+    entries = 0;
+    lookups = 0;
+    hits = 0;
+
+    windowLookups = 0;
+    windowHits = 0;
+}
+
+void PaletteMemo::checkHitRate()
+{
+    if (windowHits * PALETTE_MEMO_MIN_HIT_RATIO < windowLookups)
+    {
+        // Not worth it, free the table
+        enabled = false;
+        std::vector<PaletteMemoEntry>().swap(table);
+    }
+
+    windowLookups = 0;
+    windowHits = 0;
+}
+
+PaletteMemoEntry *PaletteMemo::insert(colors::Color color)
+{
+    if (!enabled)
+    {
+        return NULL;
+    }
+
+    // Keep the load factor under 1/2
+    if ((entries + 1) * 2 > table.size())
+    {
+        if (bits >= PALETTE_MEMO_MAX_BITS)
+        {
+            return NULL; // Full
+        }
+
+        grow();
+    }
+
+    uint32_t key = packColor(color) + 1;
+    uint32_t i = slot(key);
+
+    while (table[i].key != 0)
+    {
+        if (table[i].key == key)
+        {
+            return &table[i];
+        }
+
+        i = (i + 1) & mask;
+    }
+
+    table[i].key = key;
+    entries++;
+
+    return &table[i];
+}
+
+void PaletteMemo::grow()
+{
+    std::vector<PaletteMemoEntry> oldTable;
+    oldTable.swap(table);
+
+    bits++;
+    mask = (1u << bits) - 1;
+    table.resize(static_cast<size_t>(1) << bits);
+
+    for (size_t i = 0; i < table.size(); i++)
+    {
+        table[i].key = 0;
+    }
+
+    for (size_t j = 0; j < oldTable.size(); j++)
+    {
+        if (oldTable[j].key == 0)
+        {
+            continue;
+        }
+
+        uint32_t i = slot(oldTable[j].key);
+
+        while (table[i].key != 0)
+        {
+            i = (i + 1) & mask;
+        }
+
+        table[i] = oldTable[j];
+    }
+}
+
+void PaletteMemo::storeClosestColor(colors::Color color, size_t closest)
+{
+    PaletteMemoEntry *entry = insert(color);
+
+    if (entry != NULL)
+    {
+        entry->first = static_cast<uint16_t>(closest);
+        entry->second = static_cast<uint16_t>(closest);
+        entry->distFirst = 0;
+        entry->distSecond = 0;
+    }
+}
+
+void PaletteMemo::storeClosestColorPair(colors::Color color, const minecraft::ClosestColorPair &pair)
+{
+    PaletteMemoEntry *entry = insert(color);
+
+    if (entry != NULL)
+    {
+        entry->first = static_cast<uint16_t>(pair.first);
+        entry->second = static_cast<uint16_t>(pair.second);
+        entry->distFirst = pair.distFirst;
+        entry->distSecond = pair.distSecond;
+    }
+}
+
+PaletteMemoStats PaletteMemo::getStats() const
+{
+    PaletteMemoStats stats;
+
+    stats.lookups = lookups;
+    stats.hits = hits;
+    stats.entries = entries;
+
+    return stats;
+}
@@ -0,0 +1,231 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <cstdint>
+
+// Initial number of slots of the table (power of 2)
+#define PALETTE_MEMO_INITIAL_BITS (12)
+
+// Max number of slots of the table. When the table is full, new colors are not stored
+#define PALETTE_MEMO_MAX_BITS (18)
+
+// The hit rate is checked every this number of searches
+#define PALETTE_MEMO_WINDOW (16384)
+
+// If less than 1 of this number of searches is a hit in a window, the cache is disabled
+#define PALETTE_MEMO_MIN_HIT_RATIO (4)
+
+namespace mapart
+{
+    /**
+     * @brief  Statistics of the memo cache
+     * @retval None
+     */
+    struct PaletteMemoStats
+    {
+        // Number of searches
+        size_t lookups;
+
+        // Number of searches resolved by the cache
+        size_t hits;
+
+        // Number of colors stored
+        size_t entries;
+    };
+
+    /**
+     * @brief  Entry of the memo cache
+     * @note   key is the packed RGB value + 1 (0 means empty)
+     * @retval None
+     */
+    struct PaletteMemoEntry
+    {
+        uint32_t key;
+        uint16_t first;
+        uint16_t second;
+        double distFirst;
+        double distSecond;
+    };
+
+    /**
+     * @brief  Memo cache of closest color searches, keyed by the RGB value
+     * @note   Open addressing table with linear probing. Not thread safe,
+     *         use one per thread. Results are exact, since the closest colors
+     *         only depend on the RGB value. Use a memo for one kind of search only
+     *         (closest color or 2 closest colors).
+     *         The cache disables itself if the hit rate is too low
+     *         (images with too many unique colors, error diffusion).
+     * @retval None
+     */
+    class PaletteMemo
+    {
+    public:
+        PaletteMemo();
+
+        /**
+         * @brief  Checks if the cache is enabled
+         * @note   If disabled, search without it
+         * @retval True if enabled
+         */
+        inline bool isEnabled() const
+        {
+            return enabled;
+        }
+
+        /**
+         * @brief  Finds a stored closest color
+         * @note
+         * @param  color: Original color (RGB)
+         * @param  closest: Pointer to store the index inside the color set
+         * @retval True if found
+         */
+        inline bool findClosestColor(colors::Color color, size_t *closest)
+        {
+            const PaletteMemoEntry *entry = find(color);
+
+            if (entry == NULL)
+            {
+                return false;
+            }
+
+            *closest = entry->first;
+
+            return true;
+        }
+
+        /**
+         * @brief  Finds the stored 2 closest colors
+         * @note
+         * @param  color: Original color (RGB)
+         * @param  pair: Pointer to store the 2 closest colors
+         * @retval True if found
+         */
+        inline bool findClosestColorPair(colors::Color color, minecraft::ClosestColorPair *pair)
+        {
+            const PaletteMemoEntry *entry = find(color);
+
+            if (entry == NULL)
+            {
+                return false;
+            }
+
+            pair->first = entry->first;
+            pair->second = entry->second;
+            pair->distFirst = entry->distFirst;
+            pair->distSecond = entry->distSecond;
+
+            return true;
+        }
+
+        /**
+         * @brief  Stores the closest color
+         * @note   Call after findClosestColor returned false
+         * @param  color: Original color (RGB)
+         * @param  closest: Index inside the color set
+         * @retval None
+         */
+        void storeClosestColor(colors::Color color, size_t closest);
+
+        /**
+         * @brief  Stores the 2 closest colors
+         * @note   Call after findClosestColorPair returned false
+         * @param  color: Original color (RGB)
+         * @param  &pair: The 2 closest colors
+         * @retval None
+         */
+        void storeClosestColorPair(colors::Color color, const minecraft::ClosestColorPair &pair);
+
+        /**
+         * @brief  Gets the statistics
+         * @note
+         * @retval The statistics
+         */
+        PaletteMemoStats getStats() const;
+
+    private:
+        std::vector<PaletteMemoEntry> table;
+        uint32_t bits;
+        uint32_t mask;
+
+        bool enabled;
+
+        size_t entries;
+        size_t lookups;
+        size_t hits;
+
+        size_t windowLookups;
+        size_t windowHits;
+
+        inline static uint32_t packColor(colors::Color color)
+        {
+            return (static_cast<uint32_t>(color.red) << 16) | (static_cast<uint32_t>(color.green) << 8) | static_cast<uint32_t>(color.blue);
+        }
+
+        inline uint32_t slot(uint32_t key) const
+        {
+            return (key * 2654435761u) >> (32 - bits);
+        }
+
+        inline const PaletteMemoEntry *find(colors::Color color)
+        {
+            uint32_t key = packColor(color) + 1;
+            uint32_t i = slot(key);
+
+            lookups++;
+
+            if (++windowLookups >= PALETTE_MEMO_WINDOW)
+            {
+                checkHitRate();
+
+                if (!enabled)
+                {
+                    return NULL;
+                }
+            }
+
+            while (table[i].key != 0)
+            {
+                if (table[i].key == key)
+                {
+                    hits++;
+                    windowHits++;
+                    return &table[i];
+                }
+
+                i = (i + 1) & mask;
+            }
+
+            return NULL;
+        }
+
+        PaletteMemoEntry *insert(colors::Color color);
+
+        void grow();
+
+        void checkHitRate();
+    };
+}
@@ -0,0 +1,124 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+#include "palette_lut.h"
+#include "palette_index.h"
+#include "palette_simd.h"
+
+namespace mapart
+{
+    /**
+     * @brief  Closest color search structures for a color set
+     * @note   The lookup table is used if built. Otherwise, Euclidean distance uses
+     *         the SIMD kernels and DeltaE uses the k-d tree (the L*ab conversion of
+     *         the query dominates and the tree computes less distances)
+     * @retval None
+     */
+    struct PaletteSearch
+    {
+        PaletteLookupTable lut;
+        PaletteIndex index;
+        CompiledPalette compiled;
+        bool useCompiled;
+
+        // Precomputed L*ab plane of the original image (DeltaE only), or NULL
+        const colors::Lab *labMatrix;
+
+        // True to use the memo cache (when the lookup table is not built)
+        bool useMemo;
+
+        inline size_t findClosestColor(colors::Color color) const
+        {
+            if (lut.isBuilt())
+            {
+                return lut.findClosestColor(color);
+            }
+            else if (useCompiled)
+            {
+                return compiled.findClosestColor(color);
+            }
+            else
+            {
+                return index.findClosestColor(color);
+            }
+        }
+
+        inline minecraft::ClosestColorPair findClosestColorPair(colors::Color color) const
+        {
+            if (useCompiled)
+            {
+                return compiled.findClosestColorPair(color);
+            }
+            else
+            {
+                return index.findClosestColorPair(color);
+            }
+        }
+
+        /**
+         * @brief  Finds the closest color of a pixel
+         * @note   Uses the precomputed L*ab plane if available (only set for
+         *         the methods that do not modify the pixels)
+         * @param  *matrix: Color matrix
+         * @param  index: Index of the pixel
+         * @retval The index inside the color set
+         */
+        inline size_t findClosestPixelColor(const colors::Color *matrix, size_t index) const
+        {
+            if (labMatrix == NULL)
+            {
+                return findClosestColor(matrix[index]);
+            }
+            else if (lut.isBuilt())
+            {
+                return lut.findClosestColor(matrix[index], labMatrix[index]);
+            }
+            else
+            {
+                return this->index.findClosestColor(labMatrix[index]);
+            }
+        }
+
+        /**
+         * @brief  Finds the 2 closest colors of a pixel
+         * @note   Uses the precomputed L*ab plane if available
+         * @param  *matrix: Color matrix
+         * @param  index: Index of the pixel
+         * @retval The 2 closest colors and their distances
+         */
+        inline minecraft::ClosestColorPair findClosestPixelColorPair(const colors::Color *matrix, size_t index) const
+        {
+            if (labMatrix == NULL)
+            {
+                return findClosestColorPair(matrix[index]);
+            }
+            else
+            {
+                return this->index.findClosestColorPair(labMatrix[index]);
+            }
+        }
+    };
+}
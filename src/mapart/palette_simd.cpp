@@ -0,0 +1,640 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "palette_simd.h"
+#include "../colors/cielab.h"
+#include <cfloat>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PALETTE_SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#define PALETTE_TARGET_SSE41
+#define PALETTE_TARGET_AVX2
+#else
+#define PALETTE_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define PALETTE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Coordinates of the padding colors, far enough to never be chosen
+#define PALETTE_PADDING_RGB (1e18f)
+#define PALETTE_PADDING_LAB (1e100)
+
+using namespace std;
+using namespace colors;
+using namespace mapart;
+
+/**
+ * @brief  Best 2 results of each lane of a kernel
+ * @note   Positions are stored as floating point (exact for any palette size)
+ * @retval None
+ */
+struct PaletteLanes
+{
+    double d1[PALETTE_SIMD_BLOCK];
+    double p1[PALETTE_SIMD_BLOCK];
+    double d2[PALETTE_SIMD_BLOCK];
+    double p2[PALETTE_SIMD_BLOCK];
+    size_t lanes;
+};
+
+/* Scalar kernels */
+
+template <typename T>
+void kernelScalar(const T *c0, const T *c1, const T *c2, size_t n, T q0, T q1, T q2, PaletteLanes &res)
+{
+    T best1 = numeric_limits<T>::max();
+    T best2 = numeric_limits<T>::max();
+    size_t pos1 = 0;
+    size_t pos2 = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        T d0 = q0 - c0[i];
+        T d1 = q1 - c1[i];
+        T d2 = q2 - c2[i];
+        T d = (d0 * d0) + (d1 * d1) + (d2 * d2);
+
+        if (d < best1)
+        {
+            best2 = best1;
+            pos2 = pos1;
+            best1 = d;
+            pos1 = i;
+        }
+        else if (d < best2)
+        {
+            best2 = d;
+            pos2 = i;
+        }
+    }
+
+    res.lanes = 1;
+    res.d1[0] = best1;
+    res.p1[0] = static_cast<double>(pos1);
+    res.d2[0] = best2;
+    res.p2[0] = static_cast<double>(pos2);
+}
+
+#if defined(PALETTE_SIMD_X86)
+
+/* SSE 4.1 kernels */
+
+template <bool SECOND>
+PALETTE_TARGET_SSE41 void kernelRgbSSE41(const float *c0, const float *c1, const float *c2, size_t n, float q0, float q1, float q2, PaletteLanes &res)
+{
+    __m128 vq0 = _mm_set1_ps(q0);
+    __m128 vq1 = _mm_set1_ps(q1);
+    __m128 vq2 = _mm_set1_ps(q2);
+
+    __m128 best1 = _mm_set1_ps(FLT_MAX);
+    __m128 best2 = _mm_set1_ps(FLT_MAX);
+    __m128 pos1 = _mm_setzero_ps();
+    __m128 pos2 = _mm_setzero_ps();
+
+    __m128 pos = _mm_setr_ps(0, 1, 2, 3);
+    __m128 step = _mm_set1_ps(4);
+
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m128 d0 = _mm_sub_ps(vq0, _mm_loadu_ps(c0 + i));
+        __m128 d1 = _mm_sub_ps(vq1, _mm_loadu_ps(c1 + i));
+        __m128 d2 = _mm_sub_ps(vq2, _mm_loadu_ps(c2 + i));
+        __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(d0, d0), _mm_mul_ps(d1, d1)), _mm_mul_ps(d2, d2));
+
+        __m128 lt1 = _mm_cmplt_ps(d, best1);
+
+        if (SECOND)
+        {
+            __m128 lt2 = _mm_cmplt_ps(d, best2);
+            best2 = _mm_blendv_ps(_mm_blendv_ps(best2, d, lt2), best1, lt1);
+            pos2 = _mm_blendv_ps(_mm_blendv_ps(pos2, pos, lt2), pos1, lt1);
+        }
+
+        best1 = _mm_blendv_ps(best1, d, lt1);
+        pos1 = _mm_blendv_ps(pos1, pos, lt1);
+
+        pos = _mm_add_ps(pos, step);
+    }
+
+    float tmp[4][4];
+    _mm_storeu_ps(tmp[0], best1);
+    _mm_storeu_ps(tmp[1], pos1);
+    _mm_storeu_ps(tmp[2], best2);
+    _mm_storeu_ps(tmp[3], pos2);
+
+    res.lanes = 4;
+    for (size_t l = 0; l < 4; l++)
+    {
+        res.d1[l] = tmp[0][l];
+        res.p1[l] = tmp[1][l];
+        res.d2[l] = tmp[2][l];
+        res.p2[l] = tmp[3][l];
+    }
+}
+
+template <bool SECOND>
+PALETTE_TARGET_SSE41 void kernelLabSSE41(const double *c0, const double *c1, const double *c2, size_t n, double q0, double q1, double q2, PaletteLanes &res)
+{
+    __m128d vq0 = _mm_set1_pd(q0);
+    __m128d vq1 = _mm_set1_pd(q1);
+    __m128d vq2 = _mm_set1_pd(q2);
+
+    __m128d best1 = _mm_set1_pd(DBL_MAX);
+    __m128d best2 = _mm_set1_pd(DBL_MAX);
+    __m128d pos1 = _mm_setzero_pd();
+    __m128d pos2 = _mm_setzero_pd();
+
+    __m128d pos = _mm_setr_pd(0, 1);
+    __m128d step = _mm_set1_pd(2);
+
+    for (size_t i = 0; i < n; i += 2)
+    {
+        __m128d d0 = _mm_sub_pd(vq0, _mm_loadu_pd(c0 + i));
+        __m128d d1 = _mm_sub_pd(vq1, _mm_loadu_pd(c1 + i));
+        __m128d d2 = _mm_sub_pd(vq2, _mm_loadu_pd(c2 + i));
+        __m128d d = _mm_add_pd(_mm_add_pd(_mm_mul_pd(d0, d0), _mm_mul_pd(d1, d1)), _mm_mul_pd(d2, d2));
+
+        __m128d lt1 = _mm_cmplt_pd(d, best1);
+
+        if (SECOND)
+        {
+            __m128d lt2 = _mm_cmplt_pd(d, best2);
+            best2 = _mm_blendv_pd(_mm_blendv_pd(best2, d, lt2), best1, lt1);
+            pos2 = _mm_blendv_pd(_mm_blendv_pd(pos2, pos, lt2), pos1, lt1);
+        }
+
+        best1 = _mm_blendv_pd(best1, d, lt1);
+        pos1 = _mm_blendv_pd(pos1, pos, lt1);
+
+        pos = _mm_add_pd(pos, step);
+    }
+
+    res.lanes = 2;
+    _mm_storeu_pd(res.d1, best1);
+    _mm_storeu_pd(res.p1, pos1);
+    _mm_storeu_pd(res.d2, best2);
+    _mm_storeu_pd(res.p2, pos2);
+}
+
+/* AVX2 kernels */
+
+template <bool SECOND>
+PALETTE_TARGET_AVX2 void kernelRgbAVX2(const float *c0, const float *c1, const float *c2, size_t n, float q0, float q1, float q2, PaletteLanes &res)
+{
+    __m256 vq0 = _mm256_set1_ps(q0);
+    __m256 vq1 = _mm256_set1_ps(q1);
+    __m256 vq2 = _mm256_set1_ps(q2);
+
+    __m256 best1 = _mm256_set1_ps(FLT_MAX);
+    __m256 best2 = _mm256_set1_ps(FLT_MAX);
+    __m256 pos1 = _mm256_setzero_ps();
+    __m256 pos2 = _mm256_setzero_ps();
+
+    __m256 pos = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 step = _mm256_set1_ps(8);
+
+    for (size_t i = 0; i < n; i += 8)
+    {
+        __m256 d0 = _mm256_sub_ps(vq0, _mm256_loadu_ps(c0 + i));
+        __m256 d1 = _mm256_sub_ps(vq1, _mm256_loadu_ps(c1 + i));
+        __m256 d2 = _mm256_sub_ps(vq2, _mm256_loadu_ps(c2 + i));
+        __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(d0, d0), _mm256_mul_ps(d1, d1)), _mm256_mul_ps(d2, d2));
+
+        __m256 lt1 = _mm256_cmp_ps(d, best1, _CMP_LT_OQ);
+
+        if (SECOND)
+        {
+            __m256 lt2 = _mm256_cmp_ps(d, best2, _CMP_LT_OQ);
+            best2 = _mm256_blendv_ps(_mm256_blendv_ps(best2, d, lt2), best1, lt1);
+            pos2 = _mm256_blendv_ps(_mm256_blendv_ps(pos2, pos, lt2), pos1, lt1);
+        }
+
+        best1 = _mm256_blendv_ps(best1, d, lt1);
+        pos1 = _mm256_blendv_ps(pos1, pos, lt1);
+
+        pos = _mm256_add_ps(pos, step);
+    }
+
+    float tmp[4][8];
+    _mm256_storeu_ps(tmp[0], best1);
+    _mm256_storeu_ps(tmp[1], pos1);
+    _mm256_storeu_ps(tmp[2], best2);
+    _mm256_storeu_ps(tmp[3], pos2);
+
+    res.lanes = 8;
+    for (size_t l = 0; l < 8; l++)
+    {
+        res.d1[l] = tmp[0][l];
+        res.p1[l] = tmp[1][l];
+        res.d2[l] = tmp[2][l];
+        res.p2[l] = tmp[3][l];
+    }
+}
+
+template <bool SECOND>
+PALETTE_TARGET_AVX2 void kernelLabAVX2(const double *c0, const double *c1, const double *c2, size_t n, double q0, double q1, double q2, PaletteLanes &res)
+{
+    __m256d vq0 = _mm256_set1_pd(q0);
+    __m256d vq1 = _mm256_set1_pd(q1);
+    __m256d vq2 = _mm256_set1_pd(q2);
+
+    __m256d best1 = _mm256_set1_pd(DBL_MAX);
+    __m256d best2 = _mm256_set1_pd(DBL_MAX);
+    __m256d pos1 = _mm256_setzero_pd();
+    __m256d pos2 = _mm256_setzero_pd();
+
+    __m256d pos = _mm256_setr_pd(0, 1, 2, 3);
+    __m256d step = _mm256_set1_pd(4);
+
+    for (size_t i = 0; i < n; i += 4)
+    {
+        __m256d d0 = _mm256_sub_pd(vq0, _mm256_loadu_pd(c0 + i));
+        __m256d d1 = _mm256_sub_pd(vq1, _mm256_loadu_pd(c1 + i));
+        __m256d d2 = _mm256_sub_pd(vq2, _mm256_loadu_pd(c2 + i));
+        __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(d0, d0), _mm256_mul_pd(d1, d1)), _mm256_mul_pd(d2, d2));
+
+        __m256d lt1 = _mm256_cmp_pd(d, best1, _CMP_LT_OQ);
+
+        if (SECOND)
+        {
+            __m256d lt2 = _mm256_cmp_pd(d, best2, _CMP_LT_OQ);
+            best2 = _mm256_blendv_pd(_mm256_blendv_pd(best2, d, lt2), best1, lt1);
+            pos2 = _mm256_blendv_pd(_mm256_blendv_pd(pos2, pos, lt2), pos1, lt1);
+        }
+
+        best1 = _mm256_blendv_pd(best1, d, lt1);
+        pos1 = _mm256_blendv_pd(pos1, pos, lt1);
+
+        pos = _mm256_add_pd(pos, step);
+    }
+
+    res.lanes = 4;
+    _mm256_storeu_pd(res.d1, best1);
+    _mm256_storeu_pd(res.p1, pos1);
+    _mm256_storeu_pd(res.d2, best2);
+    _mm256_storeu_pd(res.p2, pos2);
+}
+
+#endif
+
+/**
+ * @brief  Compares 2 results, lowest position wins on tie
+ * @retval True if (d, p) is better than (bestD, bestP)
+ */
+inline bool isBetter(double d, double p, double bestD, double bestP)
+{
+    return d < bestD || (d == bestD && p < bestP);
+}
+
+PaletteKernel mapart::detectPaletteKernel()
+{
+    static const PaletteKernel detected = []() {
+#if defined(PALETTE_SIMD_X86)
+#if defined(_MSC_VER)
+        int info[4];
+
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        bool sse41 = (info[2] & (1 << 19)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        bool sse41 = __builtin_cpu_supports("sse4.1");
+        bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+        if (avx2)
+        {
+            return PaletteKernel::AVX2;
+        }
+        else if (sse41)
+        {
+            return PaletteKernel::SSE41;
+        }
+#endif
+        return PaletteKernel::Scalar;
+    }();
+
+    return detected;
+}
+
+const char *mapart::getPaletteKernelName(PaletteKernel kernel)
+{
+    switch (kernel)
+    {
+    case PaletteKernel::AVX2:
+        return "AVX2";
+    case PaletteKernel::SSE41:
+        return "SSE4.1";
+    default:
+        return "Scalar";
+    }
+}
+
+CompiledPalette::CompiledPalette()
+{
+    algo = ColorDistanceAlgorithm::Euclidean;
+    kernel = detectPaletteKernel();
+    count = 0;
+    paddedCount = 0;
+}
+
+void CompiledPalette::build(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo)
+{
+    this->algo = algo;
+
+    indexes.clear();
+
+    size_t size = colorSet.size();
+
+    // Start with i = 4 to skip all NONE blocks
+    for (size_t i = 4; i < size; i++)
+    {
+        if (colorSet[i].enabled)
+        {
+            indexes.push_back(i);
+        }
+    }
+
+    count = indexes.size();
+    paddedCount = ((count + PALETTE_SIMD_BLOCK - 1) / PALETTE_SIMD_BLOCK) * PALETTE_SIMD_BLOCK;
+
+    rgbR.clear();
+    rgbG.clear();
+    rgbB.clear();
+    labL.clear();
+    labA.clear();
+    labB.clear();
+
+    // The padding is never chosen if there are at least 2 real colors
+    if (algo == ColorDistanceAlgorithm::DeltaE)
+    {
+        labL.resize(paddedCount, PALETTE_PADDING_LAB);
+        labA.resize(paddedCount, PALETTE_PADDING_LAB);
+        labB.resize(paddedCount, PALETTE_PADDING_LAB);
+    }
+    else
+    {
+        rgbR.resize(paddedCount, PALETTE_PADDING_RGB);
+        rgbG.resize(paddedCount, PALETTE_PADDING_RGB);
+        rgbB.resize(paddedCount, PALETTE_PADDING_RGB);
+    }
+
+    for (size_t j = 0; j < count; j++)
+    {
+        const minecraft::FinalColor &c = colorSet[indexes[j]];
+
+        if (algo == ColorDistanceAlgorithm::DeltaE)
+        {
+            labL[j] = c.lab.L;
+            labA[j] = c.lab.a;
+            labB[j] = c.lab.b;
+        }
+        else
+        {
+            rgbR[j] = c.color.red;
+            rgbG[j] = c.color.green;
+            rgbB[j] = c.color.blue;
+        }
+    }
+}
+
+size_t CompiledPalette::size() const
+{
+    return count;
+}
+
+PaletteKernel CompiledPalette::getKernel() const
+{
+    return kernel;
+}
+
+void CompiledPalette::setKernel(PaletteKernel kernel)
+{
+    if (static_cast<int>(kernel) > static_cast<int>(detectPaletteKernel()))
+    {
+        this->kernel = PaletteKernel::Scalar;
+    }
+    else
+    {
+        this->kernel = kernel;
+    }
+}
+
+void CompiledPalette::search(colors::Color color, size_t *best1, double *dist1, size_t *best2, double *dist2, bool findSecond) const
+{
+    PaletteLanes lanes;
+
+    if (algo == ColorDistanceAlgorithm::DeltaE)
+    {
+        Lab lab;
+        cielab::rgbToLab(color, &lab);
+
+        const double *c0 = labL.data();
+        const double *c1 = labA.data();
+        const double *c2 = labB.data();
+
+        switch (kernel)
+        {
+#if defined(PALETTE_SIMD_X86)
+        case PaletteKernel::AVX2:
+            if (findSecond)
+            {
+                kernelLabAVX2<true>(c0, c1, c2, paddedCount, lab.L, lab.a, lab.b, lanes);
+            }
+            else
+            {
+                kernelLabAVX2<false>(c0, c1, c2, paddedCount, lab.L, lab.a, lab.b, lanes);
+            }
+            break;
+        case PaletteKernel::SSE41:
+            if (findSecond)
+            {
+                kernelLabSSE41<true>(c0, c1, c2, paddedCount, lab.L, lab.a, lab.b, lanes);
+            }
+            else
+            {
+                kernelLabSSE41<false>(c0, c1, c2, paddedCount, lab.L, lab.a, lab.b, lanes);
+            }
+            break;
+#endif
+        default:
+            kernelScalar<double>(c0, c1, c2, count, lab.L, lab.a, lab.b, lanes);
+        }
+    }
+    else
+    {
+        const float *c0 = rgbR.data();
+        const float *c1 = rgbG.data();
+        const float *c2 = rgbB.data();
+
+        float q0 = color.red;
+        float q1 = color.green;
+        float q2 = color.blue;
+
+        switch (kernel)
+        {
+#if defined(PALETTE_SIMD_X86)
+        case PaletteKernel::AVX2:
+            if (findSecond)
+            {
+                kernelRgbAVX2<true>(c0, c1, c2, paddedCount, q0, q1, q2, lanes);
+            }
+            else
+            {
+                kernelRgbAVX2<false>(c0, c1, c2, paddedCount, q0, q1, q2, lanes);
+            }
+            break;
+        case PaletteKernel::SSE41:
+            if (findSecond)
+            {
+                kernelRgbSSE41<true>(c0, c1, c2, paddedCount, q0, q1, q2, lanes);
+            }
+            else
+            {
+                kernelRgbSSE41<false>(c0, c1, c2, paddedCount, q0, q1, q2, lanes);
+            }
+            break;
+#endif
+        default:
+            kernelScalar<float>(c0, c1, c2, count, q0, q1, q2, lanes);
+        }
+    }
+
+    // Join the lanes
+    double bestD1 = lanes.d1[0];
+    double bestP1 = lanes.p1[0];
+
+    for (size_t l = 1; l < lanes.lanes; l++)
+    {
+        if (isBetter(lanes.d1[l], lanes.p1[l], bestD1, bestP1))
+        {
+            bestD1 = lanes.d1[l];
+            bestP1 = lanes.p1[l];
+        }
+    }
+
+    *best1 = indexes[static_cast<size_t>(bestP1)];
+    *dist1 = bestD1;
+
+    if (!findSecond)
+    {
+        return;
+    }
+
+    // The second is the best of the rest of candidates
+    double bestD2 = DBL_MAX;
+    double bestP2 = DBL_MAX;
+
+    for (size_t l = 0; l < lanes.lanes; l++)
+    {
+        if (lanes.p1[l] != bestP1 && isBetter(lanes.d1[l], lanes.p1[l], bestD2, bestP2))
+        {
+            bestD2 = lanes.d1[l];
+            bestP2 = lanes.p1[l];
+        }
+
+        if (lanes.p2[l] != bestP1 && isBetter(lanes.d2[l], lanes.p2[l], bestD2, bestP2))
+        {
+            bestD2 = lanes.d2[l];
+            bestP2 = lanes.p2[l];
+        }
+    }
+
+    *best2 = indexes[static_cast<size_t>(bestP2)];
+    *dist2 = bestD2;
+}
+
+size_t CompiledPalette::findClosestColor(colors::Color color) const
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    size_t best1;
+    double dist1;
+
+    search(color, &best1, &dist1, nullptr, nullptr, false);
+
+    return best1;
+}
+
+std::vector<size_t> CompiledPalette::find2ClosestColors(colors::Color color, double *distFirst, double *distSecond) const
+{
+    minecraft::ClosestColorPair pair = findClosestColorPair(color);
+
+    *distFirst = pair.distFirst;
+    *distSecond = pair.distSecond;
+
+    std::vector<size_t> v(2);
+
+    v[0] = pair.first;
+    v[1] = pair.second;
+
+    return v;
+}
+
+minecraft::ClosestColorPair CompiledPalette::findClosestColorPair(colors::Color color) const
+{
+    minecraft::ClosestColorPair pair;
+
+    if (count == 0)
+    {
+        pair.first = 0;
+        pair.second = 0;
+        pair.distFirst = 0;
+        pair.distSecond = 0;
+        return pair;
+    }
+
+    if (count == 1)
+    {
+        // Only one color
+        search(color, &pair.first, &pair.distFirst, nullptr, nullptr, false);
+        pair.second = pair.first;
+        pair.distSecond = pair.distFirst;
+    }
+    else
+    {
+        search(color, &pair.first, &pair.distFirst, &pair.second, &pair.distSecond, true);
+    }
+
+    return pair;
+}
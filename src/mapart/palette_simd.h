@@ -0,0 +1,150 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+
+// Colors are stored in blocks of this size (max lanes of the SIMD kernels)
+#define PALETTE_SIMD_BLOCK (8)
+
+namespace mapart
+{
+    /**
+     * @brief  Kernel used to compute the distances
+     */
+    enum class PaletteKernel
+    {
+        Scalar = 0,
+        SSE41 = 1,
+        AVX2 = 2,
+    };
+
+    /**
+     * @brief  Detects the best kernel supported by the CPU
+     * @note   Detected only once
+     * @retval The kernel
+     */
+    PaletteKernel detectPaletteKernel();
+
+    /**
+     * @brief  Gets the name of a kernel
+     * @note
+     * @param  kernel: The kernel
+     * @retval Name of the kernel
+     */
+    const char *getPaletteKernelName(PaletteKernel kernel);
+
+    /**
+     * @brief  Compiled palette. Structure of arrays of the enabled colors
+     * @note   Euclidean distances use floats (every intermediate value is an
+     *         exact integer, so results are the same as with doubles).
+     *         L*ab distances use doubles, with the same operations as
+     *         colors::colorDistance, so results are the same as the scalar search.
+     *         Ties are resolved to the lowest index, like the linear search.
+     * @retval None
+     */
+    class CompiledPalette
+    {
+    public:
+        CompiledPalette();
+
+        /**
+         * @brief  Builds the compiled palette
+         * @note
+         * @param  &colorSet: Color set (only enabled colors are used)
+         * @param  algo: Color distance algorithm
+         * @retval None
+         */
+        void build(const std::vector<minecraft::FinalColor> &colorSet, colors::ColorDistanceAlgorithm algo);
+
+        /**
+         * @brief  Gets the number of enabled colors
+         * @note
+         * @retval Number of colors
+         */
+        size_t size() const;
+
+        /**
+         * @brief  Gets the kernel in use
+         * @note
+         * @retval The kernel
+         */
+        PaletteKernel getKernel() const;
+
+        /**
+         * @brief  Sets the kernel to use
+         * @note   Only kernels supported by the CPU can be used, others fall back to scalar
+         * @param  kernel: The kernel
+         * @retval None
+         */
+        void setKernel(PaletteKernel kernel);
+
+        /**
+         * @brief  Finds the closest color
+         * @note
+         * @param  color: Original color (RGB)
+         * @retval The index inside the color set (0 if there are no enabled colors)
+         */
+        size_t findClosestColor(colors::Color color) const;
+
+        /**
+         * @brief  Finds the 2 closest colors
+         * @note   If there is only one enabled color, it is returned twice
+         * @param  color: Original color (RGB)
+         * @param  distFirst: Pointer to store the distance of the closest color
+         * @param  distSecond: Pointer to store the distance of the second closest color
+         * @retval Vector with the 2 indexes inside the color set
+         */
+        std::vector<size_t> find2ClosestColors(colors::Color color, double *distFirst, double *distSecond) const;
+
+        /**
+         * @brief  Finds the 2 closest colors
+         * @note   Same as find2ClosestColors, without allocating memory
+         * @param  color: Original color (RGB)
+         * @retval The 2 closest colors and their distances
+         */
+        minecraft::ClosestColorPair findClosestColorPair(colors::Color color) const;
+
+    private:
+        colors::ColorDistanceAlgorithm algo;
+        PaletteKernel kernel;
+
+        size_t count;
+        size_t paddedCount;
+
+        std::vector<size_t> indexes;
+
+        // Euclidean (RGB)
+        std::vector<float> rgbR;
+        std::vector<float> rgbG;
+        std::vector<float> rgbB;
+
+        // DeltaE (L*ab)
+        std::vector<double> labL;
+        std::vector<double> labA;
+        std::vector<double> labB;
+
+        void search(colors::Color color, size_t *best1, double *dist1, size_t *best2, double *dist2, bool findSecond) const;
+    };
+}
@@ -64,6 +64,7 @@ MapArtProject::MapArtProject()
     // Map params
     colorDistanceAlgorithm = ColorDistanceAlgorithm::Euclidean;
     ditheringMethod = DitheringMethod::None;
+    diffusionMode = ErrorDiffusionMode::Exact;
     buildMethod = MapBuildMethod::Staircased;
 
     // Image size
@@ -114,6 +115,7 @@ MapArtProject::MapArtProject(const MapArtProject &p1)
     // Map params
     colorDistanceAlgorithm = p1.colorDistanceAlgorithm;
     ditheringMethod = p1.ditheringMethod;
+    diffusionMode = p1.diffusionMode;
     buildMethod = p1.buildMethod;
 
     // Image size
@@ -222,6 +224,20 @@ bool MapArtProject::loadFromFile(std::string path)
             ditheringMethod = DitheringMethod::None;
         }
 
+        if (comp.has_key("diffusion_mode"))
+        {
+            diffusionMode = mapart::parseErrorDiffusionModeFromString(comp.at("diffusion_mode").as<nbt::tag_string>().get());
+
+            if (diffusionMode == ErrorDiffusionMode::Unknown)
+            {
+                diffusionMode = ErrorDiffusionMode::Exact;
+            }
+        }
+        else
+        {
+            diffusionMode = ErrorDiffusionMode::Exact;
+        }
+
         paramStr = comp.at("build_method").as<nbt::tag_string>().get();
         if (paramStr.compare("flat") == 0)
         {
@@ -326,6 +342,7 @@ bool MapArtProject::saveToFile(std::string path)
     }
 
     root.insert("dithering", nbt::tag_string(ditheringMethodToString(ditheringMethod)));
+    root.insert("diffusion_mode", nbt::tag_string(errorDiffusionModeToString(diffusionMode)));
 
     switch (buildMethod)
     {
@@ -400,13 +417,14 @@ std::vector<colors::Color> MapArtProject::getColors()
     return result;
 }
 
-std::vector<bool> MapArtProject::getTransparency()
+TransparencyMask MapArtProject::getTransparency()
 {
-    std::vector<bool> result(width * height);
+    TransparencyMask result;
+    result.init(width * height, false);
 
     for (size_t i = 0; i < result.size(); i++)
     {
-        result[i] = image_alpha[i] == 0;
+        result.setTransparent(i, image_alpha[i] == 0);
     }
 
     return result;
@@ -471,32 +489,22 @@ void MapArtProject::loadImage(wxImage &image)
     }
 }
 
-MapArtPreviewData::MapArtPreviewData(std::vector<const minecraft::FinalColor *> colors, std::vector<bool> transparency, int width, int height, bool preserveTransparency)
+MapArtPreviewData::MapArtPreviewData(const std::vector<map_color_t> &colors, const std::vector<minecraft::FinalColor> &colorSet, const TransparencyMask &transparency, int width, int height, bool preserveTransparency)
 {
     this->width = width;
     this->height = height;
 
     this->preserveTransparency = preserveTransparency;
 
-    this->colors.resize(colors.size());
-
-    for (size_t i = 0; i < colors.size(); i++)
-    {
-        this->colors[i] = colors[i]->color;
-    }
-
-    this->transparency.resize(transparency.size());
-
-    for (size_t i = 0; i < transparency.size(); i++)
-    {
-        this->transparency[i] = transparency[i];
-    }
+    this->colors = colors;
+    this->colorSet = colorSet;
+    this->transparency = transparency;
 }
 
 MapArtPreviewData::MapArtPreviewData()
 {
     this->colors.resize(0);
-    this->transparency.resize(0);
+    this->transparency.init(0, false);
     this->width = 0;
     this->height = 0;
     this->preserveTransparency = false;
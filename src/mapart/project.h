@@ -24,6 +24,7 @@
 #pragma once
 
 #include "common.h"
+#include "transparency_mask.h"
 
 #include <wx/wxprec.h>
 #ifndef WX_PRECOMP
@@ -53,6 +54,7 @@ namespace mapart
         mapart::MapBuildMethod buildMethod;
         colors::ColorDistanceAlgorithm colorDistanceAlgorithm;
         mapart::DitheringMethod ditheringMethod;
+        mapart::ErrorDiffusionMode diffusionMode;
 
         minecraft::McVersion version;
 
@@ -73,7 +75,7 @@ namespace mapart
         bool saveToFile(std::string path);
 
         std::vector<colors::Color> getColors();
-        std::vector<bool> getTransparency();
+        TransparencyMask getTransparency();
 
         wxImage toImage();
 
@@ -83,13 +85,14 @@ namespace mapart
     class MapArtPreviewData
     {
     public:
-        std::vector<colors::Color> colors;
-        std::vector<bool> transparency;
+        std::vector<map_color_t> colors;
+        std::vector<minecraft::FinalColor> colorSet; // Palette of the map colors
+        TransparencyMask transparency;
         int width;
         int height;
         bool preserveTransparency;
 
         MapArtPreviewData();
-        MapArtPreviewData(std::vector<const minecraft::FinalColor *> colors, std::vector<bool> transparency, int width, int height, bool preserveTransparency);
+        MapArtPreviewData(const std::vector<map_color_t> &colors, const std::vector<minecraft::FinalColor> &colorSet, const TransparencyMask &transparency, int width, int height, bool preserveTransparency);
     };
 }
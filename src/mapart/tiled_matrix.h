@@ -0,0 +1,167 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "common.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Number of cells of a tile (one map)
+#define TILED_MATRIX_TILE_SIZE (MAP_WIDTH * MAP_HEIGHT)
+
+namespace mapart
+{
+    /**
+     * @brief  Matrix stored by maps (tile-major)
+     * @note   Each map (MAP_WIDTH x MAP_HEIGHT) is a contiguous block, in rows of MAP_WIDTH,
+     *         and the maps are stored left to right, up to down. So the stages working
+     *         map by map (map files, building) read a small contiguous region,
+     *         instead of strides of the width of the whole image.
+     *         The size is rounded up to whole maps (the padding cells keep their default value).
+     * @retval None
+     */
+    template <typename T>
+    class TiledMatrix
+    {
+    public:
+        TiledMatrix() : width(0), height(0), mapsCountX(0), mapsCountZ(0)
+        {
+        }
+
+        /**
+         * @brief  Loads a matrix stored by rows
+         * @note
+         * @param  &matrix: The matrix (row-major)
+         * @param  width: Width of the matrix
+         * @param  height: Height of the matrix
+         * @retval None
+         */
+        void load(const std::vector<T> &matrix, size_t width, size_t height)
+        {
+            this->width = width;
+            this->height = height;
+            mapsCountX = (width + MAP_WIDTH - 1) / MAP_WIDTH;
+            mapsCountZ = (height + MAP_HEIGHT - 1) / MAP_HEIGHT;
+
+            cells.assign(mapsCountX * mapsCountZ * TILED_MATRIX_TILE_SIZE, T());
+
+            // Copy each row, split by maps
+            for (size_t z = 0; z < height; z++)
+            {
+                for (size_t fromX = 0; fromX < width; fromX += MAP_WIDTH)
+                {
+                    size_t toX = std::min(fromX + MAP_WIDTH, width);
+                    std::copy(matrix.begin() + (z * width + fromX), matrix.begin() + (z * width + toX), cells.begin() + getIndex(fromX, z));
+                }
+            }
+        }
+
+        /**
+         * @brief  Gets the width
+         * @note
+         * @retval Width of the matrix
+         */
+        size_t getWidth() const
+        {
+            return width;
+        }
+
+        /**
+         * @brief  Gets the height
+         * @note
+         * @retval Height of the matrix
+         */
+        size_t getHeight() const
+        {
+            return height;
+        }
+
+        /**
+         * @brief  Gets the number of maps in the X axis
+         * @note
+         * @retval Number of maps
+         */
+        size_t getMapsCountX() const
+        {
+            return mapsCountX;
+        }
+
+        /**
+         * @brief  Gets the number of maps in the Z axis
+         * @note
+         * @retval Number of maps
+         */
+        size_t getMapsCountZ() const
+        {
+            return mapsCountZ;
+        }
+
+        /**
+         * @brief  Gets the index of a cell
+         * @note
+         * @param  x: X coordinate
+         * @param  z: Z coordinate
+         * @retval The index in the storage
+         */
+        inline size_t getIndex(size_t x, size_t z) const
+        {
+            size_t tile = (z / MAP_HEIGHT) * mapsCountX + (x / MAP_WIDTH);
+            return tile * TILED_MATRIX_TILE_SIZE + (z % MAP_HEIGHT) * MAP_WIDTH + (x % MAP_WIDTH);
+        }
+
+        /**
+         * @brief  Gets a cell
+         * @note
+         * @param  x: X coordinate
+         * @param  z: Z coordinate
+         * @retval The value of the cell
+         */
+        inline const T &at(size_t x, size_t z) const
+        {
+            return cells[getIndex(x, z)];
+        }
+
+        /**
+         * @brief  Gets the cells of a map
+         * @note   Index of a cell inside the map: z * MAP_WIDTH + x
+         * @param  mapX: Map X index
+         * @param  mapZ: Map Z index
+         * @retval Pointer to the first cell of the map
+         */
+        inline const T *getTile(size_t mapX, size_t mapZ) const
+        {
+            return &cells[(mapZ * mapsCountX + mapX) * TILED_MATRIX_TILE_SIZE];
+        }
+
+    private:
+        std::vector<T> cells;
+
+        size_t width;
+        size_t height;
+        size_t mapsCountX;
+        size_t mapsCountZ;
+    };
+}
@@ -0,0 +1,95 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "transparency_mask.h"
+
+#include <bitset>
+
+using namespace std;
+using namespace mapart;
+
+/**
+ * @brief  Counts the bits set in a word
+ * @param  word: The word
+ * @retval Number of bits set
+ */
+inline size_t countBits(uint64_t word)
+{
+    return bitset<TRANSPARENCY_MASK_WORD_BITS>(word).count();
+}
+
+TransparencyMask::TransparencyMask()
+{
+    count = 0;
+}
+
+void TransparencyMask::init(size_t size, bool transparent)
+{
+    count = size;
+    words.assign((size + TRANSPARENCY_MASK_WORD_BITS - 1) / TRANSPARENCY_MASK_WORD_BITS, transparent ? ~static_cast<uint64_t>(0) : 0);
+
+    // Clear the bits after the last pixel
+    if (transparent && (size % TRANSPARENCY_MASK_WORD_BITS) != 0)
+    {
+        words.back() = (static_cast<uint64_t>(1) << (size % TRANSPARENCY_MASK_WORD_BITS)) - 1;
+    }
+}
+
+size_t TransparencyMask::size() const
+{
+    return count;
+}
+
+size_t TransparencyMask::countTransparent(size_t from, size_t to) const
+{
+    if (from >= to)
+    {
+        return 0;
+    }
+
+    size_t firstWord = from / TRANSPARENCY_MASK_WORD_BITS;
+    size_t lastWord = (to - 1) / TRANSPARENCY_MASK_WORD_BITS;
+
+    // Bits of the range in the first and last words
+    uint64_t firstMask = ~static_cast<uint64_t>(0) << (from % TRANSPARENCY_MASK_WORD_BITS);
+    uint64_t lastMask = ~static_cast<uint64_t>(0) >> (TRANSPARENCY_MASK_WORD_BITS - 1 - ((to - 1) % TRANSPARENCY_MASK_WORD_BITS));
+
+    if (firstWord == lastWord)
+    {
+        return countBits(words[firstWord] & firstMask & lastMask);
+    }
+
+    size_t result = countBits(words[firstWord] & firstMask) + countBits(words[lastWord] & lastMask);
+
+    for (size_t w = firstWord + 1; w < lastWord; w++)
+    {
+        result += countBits(words[w]);
+    }
+
+    return result;
+}
+
+const uint64_t *TransparencyMask::getWords() const
+{
+    return words.data();
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels of each word of the mask
+#define TRANSPARENCY_MASK_WORD_BITS (64)
+
+namespace mapart
+{
+    /**
+     * @brief  Transparency of the pixels of an image (1 bit per pixel)
+     * @note   Stored in 64 bit words, so the transparent pixels of a range
+     *         (a row, a map) are counted with one popcount per word,
+     *         to skip fully opaque or fully transparent ranges.
+     *         The bits after the last pixel are always 0.
+     * @retval None
+     */
+    class TransparencyMask
+    {
+    public:
+        TransparencyMask();
+
+        /**
+         * @brief  Initializes the mask
+         * @note
+         * @param  size: Number of pixels
+         * @param  transparent: Initial value of all the pixels
+         * @retval None
+         */
+        void init(size_t size, bool transparent);
+
+        /**
+         * @brief  Gets the number of pixels
+         * @note
+         * @retval Number of pixels
+         */
+        size_t size() const;
+
+        /**
+         * @brief  Checks if a pixel is transparent
+         * @note
+         * @param  i: Index of the pixel
+         * @retval True if transparent
+         */
+        inline bool isTransparent(size_t i) const
+        {
+            return ((words[i / TRANSPARENCY_MASK_WORD_BITS] >> (i % TRANSPARENCY_MASK_WORD_BITS)) & 1) != 0;
+        }
+
+        /**
+         * @brief  Sets the transparency of a pixel
+         * @note   Not thread safe (pixels share words)
+         * @param  i: Index of the pixel
+         * @param  transparent: True if transparent
+         * @retval None
+         */
+        inline void setTransparent(size_t i, bool transparent)
+        {
+            uint64_t bit = static_cast<uint64_t>(1) << (i % TRANSPARENCY_MASK_WORD_BITS);
+
+            if (transparent)
+            {
+                words[i / TRANSPARENCY_MASK_WORD_BITS] |= bit;
+            }
+            else
+            {
+                words[i / TRANSPARENCY_MASK_WORD_BITS] &= ~bit;
+            }
+        }
+
+        /**
+         * @brief  Counts the transparent pixels of a range
+         * @note
+         * @param  from: First pixel
+         * @param  to: Pixel after the last one
+         * @retval Number of transparent pixels
+         */
+        size_t countTransparent(size_t from, size_t to) const;
+
+        /**
+         * @brief  Gets the words of the mask
+         * @note   Pixel i is the bit (i % 64) of the word (i / 64)
+         * @retval Pointer to the first word
+         */
+        const uint64_t *getWords() const;
+
+    private:
+        std::vector<uint64_t> words;
+        size_t count;
+    };
+}
@@ -368,12 +368,27 @@ size_t minecraft::findClosestColor(const std::vector<minecraft::FinalColor> &col
 }
 
 std::vector<size_t> minecraft::find2ClosestColors(const std::vector<minecraft::FinalColor> &colors, colors::Color color, colors::ColorDistanceAlgorithm algo, double *distFirst, double *distSecond)
+{
+    ClosestColorPair pair = findClosestColorPair(colors, color, algo);
+
+    *distFirst = pair.distFirst;
+    *distSecond = pair.distSecond;
+
+    std::vector<size_t> v(2);
+
+    v[0] = pair.first;
+    v[1] = pair.second;
+
+    return v;
+}
+
+minecraft::ClosestColorPair minecraft::findClosestColorPair(const std::vector<minecraft::FinalColor> &colors, colors::Color color, colors::ColorDistanceAlgorithm algo)
 {
     size_t size = colors.size();
     size_t res1 = 0;
     size_t res2 = 0;
-    double distance1;
-    double distance2;
+    double distance1 = 0;
+    double distance2 = 0;
 
     colors::Lab colorALab;
 
@@ -390,35 +405,18 @@ std::vector<size_t> minecraft::find2ClosestColors(const std::vector<minecraft::F
             continue;
         }
         double d = (algo == ColorDistanceAlgorithm::DeltaE) ? colorDistance(&colorALab, &(colors[i].lab)) : colorDistance(colors[i].color, color);
-        if (res1 > 1)
-        {
-            if (distance1 > d)
-            {
-                distance1 = d;
-                res1 = i;
-            }
-        }
-        else
+        if (res1 == 0 || distance1 > d)
         {
+            // New closest, the old one becomes the second
+            res2 = res1;
+            distance2 = distance1;
             distance1 = d;
             res1 = i;
         }
-
-        if (i != res1)
+        else if (res2 == 0 || distance2 > d)
         {
-            if (res2 > 0)
-            {
-                if (distance2 > d)
-                {
-                    distance2 = d;
-                    res2 = i;
-                }
-            }
-            else
-            {
-                distance2 = d;
-                res2 = i;
-            }
+            distance2 = d;
+            res2 = i;
         }
     }
 
@@ -428,15 +426,14 @@ std::vector<size_t> minecraft::find2ClosestColors(const std::vector<minecraft::F
         distance2 = distance1;
     }
 
-    *distFirst = distance1;
-    *distSecond = distance2;
+    ClosestColorPair pair;
 
-    std::vector<size_t> v(2);
+    pair.first = res1;
+    pair.second = res2;
+    pair.distFirst = distance1;
+    pair.distSecond = distance2;
 
-    v[0] = res1;
-    v[1] = res2;
-
-    return v;
+    return pair;
 }
 
 void minecraft::initializeEnabledColors(std::vector<minecraft::FinalColor> &colors, bool blacklist)
@@ -207,6 +207,19 @@ namespace minecraft
      */
     std::vector<minecraft::FinalColor> loadFinalColors(std::vector<colors::Color> &baseColors);
 
+    /**
+     * @brief  Result of a search of the 2 closest colors
+     * @note   If there is only one color, both are the same
+     * @retval None
+     */
+    struct ClosestColorPair
+    {
+        size_t first;
+        size_t second;
+        double distFirst;
+        double distSecond;
+    };
+
     /**
      * @brief  Finds the best color
      * @note   
@@ -229,6 +242,16 @@ namespace minecraft
      */
     std::vector<size_t> find2ClosestColors(const std::vector<minecraft::FinalColor> &colors, colors::Color color, colors::ColorDistanceAlgorithm algo, double * distFirst, double * distSecond);
 
+    /**
+     * @brief  Finds the 2 closest colors
+     * @note   Same as find2ClosestColors, without allocating memory
+     * @param  &colors: List of colors
+     * @param  color: Original color (RGB)
+     * @param  algo: Algorithm to compute the distance
+     * @retval The 2 closest colors and their distances
+     */
+    minecraft::ClosestColorPair findClosestColorPair(const std::vector<minecraft::FinalColor> &colors, colors::Color color, colors::ColorDistanceAlgorithm algo);
+
     /**
      * @brief  Initializaes colors list enabled properties
      * @note   
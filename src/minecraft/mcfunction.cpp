@@ -30,15 +30,20 @@
 using namespace std;
 using namespace minecraft;
 
-void minecraft::writeMcFunctionFile(std::string fileName, std::vector<mapart::MapBuildingBlock> &buildData, minecraft::McVersion version)
+void minecraft::writeMcFunctionFile(std::string fileName, const mapart::MapBuildPlan &buildData, minecraft::McVersion version, const threading::CancellationToken &cancel)
 {
     stringstream fileSS;
-    for (size_t i = 0; i < buildData.size(); i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
-        if (buildData[i].z > 0 && buildData[i].block_ptr != NULL)
+        if (cancel.isCancelled())
+        {
+            return; // Nothing is written
+        }
+
+        if (block.z > 0 && block.block_ptr != NULL)
         { // Ignore first line
-            int x = buildData[i].x;
-            int z = buildData[i].z - 1;
+            int x = block.x;
+            int z = block.z - 1;
 
             stringstream ss;
 
@@ -46,40 +51,40 @@ void minecraft::writeMcFunctionFile(std::string fileName, std::vector<mapart::Ma
             {
             case McVersion::MC_1_12:
                 ss << "setblock "
-                   << "~" << x << " ~ ~" << z << " minecraft:" << buildData[i].block_ptr->nbtName << " " << buildData[i].block_ptr->dataValue;
+                   << "~" << x << " ~ ~" << z << " minecraft:" << block.block_ptr->nbtName << " " << block.block_ptr->dataValue;
                 break;
             default:
                 // After 1.12, they removed the data values
                 ss << "setblock "
-                   << "~" << x << " ~ ~" << z << " minecraft:" << buildData[i].block_ptr->nbtName;
+                   << "~" << x << " ~ ~" << z << " minecraft:" << block.block_ptr->nbtName;
 
                 // Instead, add the NBT tags
 
-                if (buildData[i].block_ptr->nbtTags.size() > 0)
+                if (block.block_ptr->nbtTags.size() > 0)
                 {
                     if (version >= McVersion::MC_1_21)
                     {
                         ss << "[";
-                        for (size_t j = 0; j < buildData[i].block_ptr->nbtTags.size(); j++)
+                        for (size_t j = 0; j < block.block_ptr->nbtTags.size(); j++)
                         {
                             if (j > 0)
                             {
                                 ss << ",";
                             }
-                            ss << buildData[i].block_ptr->nbtTags[j].name << "=" << buildData[i].block_ptr->nbtTags[j].value;
+                            ss << block.block_ptr->nbtTags[j].name << "=" << block.block_ptr->nbtTags[j].value;
                         }
                         ss << "]";
                     }
                     else
                     {
                         ss << "{";
-                        for (size_t j = 0; j < buildData[i].block_ptr->nbtTags.size(); j++)
+                        for (size_t j = 0; j < block.block_ptr->nbtTags.size(); j++)
                         {
                             if (j > 0)
                             {
                                 ss << ",";
                             }
-                            ss << buildData[i].block_ptr->nbtTags[j].name << ":" << buildData[i].block_ptr->nbtTags[j].value;
+                            ss << block.block_ptr->nbtTags[j].name << ":" << block.block_ptr->nbtTags[j].value;
                         }
                         ss << "}";
                     }
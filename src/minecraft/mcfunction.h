@@ -23,7 +23,8 @@
 
 #pragma once
 
-#include "../mapart/common.h"
+#include "../mapart/build_plan.h"
+#include "../threads/cancellation.h"
 
 namespace minecraft {
     
@@ -33,7 +34,8 @@ namespace minecraft {
      * @param  fileName: File
      * @param  &buildData: Building blocks data
      * @param  version: Minecraft version
+     * @param  cancel: Cancellation token (if cancelled, the file is not written)
      * @retval None
      */
-    void writeMcFunctionFile(std::string fileName, std::vector<mapart::MapBuildingBlock> &buildData, minecraft::McVersion version);
+    void writeMcFunctionFile(std::string fileName, const mapart::MapBuildPlan &buildData, minecraft::McVersion version, const threading::CancellationToken &cancel);
 }
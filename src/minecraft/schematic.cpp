@@ -30,6 +30,7 @@
 #include <sstream>
 
 #include <cstring>
+#include <cstdio>
 
 using namespace std;
 using namespace mapart;
@@ -66,7 +67,7 @@ std::string blockDescriptionToTagName(const minecraft::BlockDescription *desc)
     return ss.str();
 }
 
-void minecraft::writeSchematicNBTFile(std::string fileName, std::vector<mapart::MapBuildingBlock> &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase)
+void minecraft::writeSchematicNBTFile(std::string fileName, const mapart::MapBuildPlan &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase, const threading::CancellationToken &cancel)
 {
     nbt::tag_compound root;
     nbt::tag_compound schematic;
@@ -108,11 +109,10 @@ void minecraft::writeSchematicNBTFile(std::string fileName, std::vector<mapart::
 
     // Compute y level
 
-    size_t size = buildData.size();
-    for (size_t i = 0; i < size; i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
         // Compute max y level for size
-        int y = buildData[i].y + 1;
+        int y = block.y + 1;
         if (y > maxYlevel)
         {
             maxYlevel = y;
@@ -125,17 +125,17 @@ void minecraft::writeSchematicNBTFile(std::string fileName, std::vector<mapart::
 
     vector<int8_t> &&blocks = vector<int8_t>(total_width * total_length * total_height, 0);
 
-    for (size_t i = 0; i < size; i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
-        size_t x = buildData[i].x;
-        size_t y = buildData[i].y;
-        size_t z = buildData[i].z;
+        size_t x = block.x;
+        size_t y = block.y;
+        size_t z = block.z;
 
         size_t block_index_base = x + z * total_width + y * total_width * total_length;
         size_t block_index = x + z * total_width + (y + 1) * total_width * total_length;
 
         // Add the blocks
-        const minecraft::BlockDescription *blockPtr = buildData[i].block_ptr;
+        const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
         if (blockPtr == NULL)
         {
@@ -193,6 +193,11 @@ void minecraft::writeSchematicNBTFile(std::string fileName, std::vector<mapart::
 
     root.insert("Schematic", schematic.clone());
 
+    if (cancel.isCancelled())
+    {
+        return;
+    }
+
     // Save
     std::ofstream file(fileName, std::ios::binary);
 
@@ -204,16 +209,33 @@ void minecraft::writeSchematicNBTFile(std::string fileName, std::vector<mapart::
     try
     {
         zlib::ozlibstream ogzs(file, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            // Remove the incomplete file
+            file.close();
+            std::remove(fileName.c_str());
+            return;
+        }
+
         throw -2;
     }
 }
 
-void minecraft::writeSchematicNBTFileCompact(std::string fileName, std::vector<std::vector<mapart::MapBuildingBlock>> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, threading::Progress &progress)
+void minecraft::writeSchematicNBTFileCompact(std::string fileName, std::vector<mapart::MapBuildPlan> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, threading::Progress &progress)
 {
+    const threading::CancellationToken &cancel = progress.getCancellationToken();
+
     nbt::tag_compound root;
     nbt::tag_compound schematic;
 
@@ -257,15 +279,14 @@ void minecraft::writeSchematicNBTFileCompact(std::string fileName, std::vector<s
 
     for (size_t chunk_i = 0; chunk_i < chunk_count; chunk_i++)
     {
-        std::vector<mapart::MapBuildingBlock> *buildData = &chunks[chunk_i];
+        const mapart::MapBuildPlan *buildData = &chunks[chunk_i];
 
         size_t offset_x = chunk_i * MAP_WIDTH;
 
-        size_t size = buildData->size();
-        for (size_t i = 0; i < size; i++)
+        for (const mapart::MapBuildingBlock block : *buildData)
         {
             // Compute max y level for size
-            int y = buildData->at(i).y + 1;
+            int y = block.y + 1;
             if (y > maxYlevel)
             {
                 maxYlevel = y;
@@ -281,22 +302,21 @@ void minecraft::writeSchematicNBTFileCompact(std::string fileName, std::vector<s
 
     for (size_t chunk_i = 0; chunk_i < chunk_count; chunk_i++)
     {
-        std::vector<mapart::MapBuildingBlock> *buildData = &chunks[chunk_i];
+        const mapart::MapBuildPlan *buildData = &chunks[chunk_i];
 
         size_t offset_x = chunk_i * MAP_WIDTH;
 
-        size_t size = buildData->size();
-        for (size_t i = 0; i < size; i++)
+        for (const mapart::MapBuildingBlock block : *buildData)
         {
-            size_t x = buildData->at(i).x + offset_x;
-            size_t y = buildData->at(i).y;
-            size_t z = buildData->at(i).z;
+            size_t x = block.x + offset_x;
+            size_t y = block.y;
+            size_t z = block.z;
 
             size_t block_index_base = x + z * total_width + y * total_width * total_length;
             size_t block_index = x + z * total_width + (y + 1) * total_width * total_length;
 
             // Add the blocks
-            const minecraft::BlockDescription *blockPtr = buildData->at(i).block_ptr;
+            const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
             if (blockPtr == NULL)
             {
@@ -321,14 +341,12 @@ void minecraft::writeSchematicNBTFileCompact(std::string fileName, std::vector<s
             }
         }
 
-        try
-        {
-            progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
-        }
-        catch (int)
+        if (cancel.isCancelled())
         {
             return;
         }
+
+        progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
     }
 
     // Data version tags
@@ -371,16 +389,33 @@ void minecraft::writeSchematicNBTFileCompact(std::string fileName, std::vector<s
     try
     {
         zlib::ozlibstream ogzs(file, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            // Remove the incomplete file
+            file.close();
+            std::remove(fileName.c_str());
+            return;
+        }
+
         throw -2;
     }
 }
 
-void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vector<std::vector<mapart::MapBuildingBlock>> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, size_t width, minecraft::McVersion version, threading::Progress &progress)
+void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vector<mapart::MapBuildPlan> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, size_t width, minecraft::McVersion version, threading::Progress &progress)
 {
+    const threading::CancellationToken &cancel = progress.getCancellationToken();
+
     nbt::tag_compound root;
     nbt::tag_compound schematic;
 
@@ -425,15 +460,14 @@ void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vect
 
     for (size_t chunk_i = 0; chunk_i < chunk_count; chunk_i++)
     {
-        std::vector<mapart::MapBuildingBlock> *buildData = &chunks[chunk_i];
+        const mapart::MapBuildPlan *buildData = &chunks[chunk_i];
 
         size_t offset_x = chunk_i * MAP_WIDTH;
 
-        size_t size = buildData->size();
-        for (size_t i = 0; i < size; i++)
+        for (const mapart::MapBuildingBlock block : *buildData)
         {
             // Compute max y level for size
-            int y = buildData->at(i).y + 1;
+            int y = block.y + 1;
             if (y > maxYlevel)
             {
                 maxYlevel = y;
@@ -449,7 +483,7 @@ void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vect
 
     for (size_t chunk_i = 0; chunk_i < chunk_count; chunk_i++)
     {
-        std::vector<mapart::MapBuildingBlock> *buildData = &chunks[chunk_i];
+        const mapart::MapBuildPlan *buildData = &chunks[chunk_i];
 
         size_t chunk_x = chunk_i % width;
         size_t chunk_z = chunk_i / width;
@@ -457,18 +491,17 @@ void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vect
         size_t offset_z = chunk_z * MAP_HEIGHT;
         size_t offset_x = chunk_x * MAP_WIDTH;
 
-        size_t size = buildData->size();
-        for (size_t i = 0; i < size; i++)
+        for (const mapart::MapBuildingBlock block : *buildData)
         {
-            size_t x = buildData->at(i).x + offset_x;
-            size_t y = buildData->at(i).y;
-            size_t z = buildData->at(i).z + offset_z;
+            size_t x = block.x + offset_x;
+            size_t y = block.y;
+            size_t z = block.z + offset_z;
 
             size_t block_index_base = x + z * total_width + y * total_width * total_length;
             size_t block_index = x + z * total_width + (y + 1) * total_width * total_length;
 
             // Add the blocks
-            const minecraft::BlockDescription *blockPtr = buildData->at(i).block_ptr;
+            const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
             if (blockPtr == NULL)
             {
@@ -496,14 +529,12 @@ void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vect
             }
         }
 
-        try
-        {
-            progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
-        }
-        catch (int)
+        if (cancel.isCancelled())
         {
             return;
         }
+
+        progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
     }
 
     // Data version tags
@@ -546,15 +577,30 @@ void minecraft::writeSchematicNBTFileCompactFlat(std::string fileName, std::vect
     try
     {
         zlib::ozlibstream ogzs(file, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            // Remove the incomplete file
+            file.close();
+            std::remove(fileName.c_str());
+            return;
+        }
+
         throw -2;
     }
 }
 
-void minecraft::writeSchematicNBTFileZip(std::string fileName, zip_t *zipper, std::vector<mapart::MapBuildingBlock> &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase)
+void minecraft::writeSchematicNBTFileZip(std::string fileName, zip_t *zipper, const mapart::MapBuildPlan &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase, const threading::CancellationToken &cancel)
 {
     nbt::tag_compound root;
     nbt::tag_compound schematic;
@@ -596,11 +642,10 @@ void minecraft::writeSchematicNBTFileZip(std::string fileName, zip_t *zipper, st
 
     // Compute y level
 
-    size_t size = buildData.size();
-    for (size_t i = 0; i < size; i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
         // Compute max y level for size
-        int y = buildData[i].y + 1;
+        int y = block.y + 1;
         if (y > maxYlevel)
         {
             maxYlevel = y;
@@ -613,17 +658,17 @@ void minecraft::writeSchematicNBTFileZip(std::string fileName, zip_t *zipper, st
 
     vector<int8_t> &&blocks = vector<int8_t>(total_width * total_length * total_height, 0);
 
-    for (size_t i = 0; i < size; i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
-        size_t x = buildData[i].x;
-        size_t y = buildData[i].y;
-        size_t z = buildData[i].z;
+        size_t x = block.x;
+        size_t y = block.y;
+        size_t z = block.z;
 
         size_t block_index_base = x + z * total_width + y * total_width * total_length;
         size_t block_index = x + z * total_width + (y + 1) * total_width * total_length;
 
         // Add the blocks
-        const minecraft::BlockDescription *blockPtr = buildData[i].block_ptr;
+        const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
         if (blockPtr == NULL)
         {
@@ -680,13 +725,25 @@ void minecraft::writeSchematicNBTFileZip(std::string fileName, zip_t *zipper, st
 
     root.insert("Schematic", schematic.clone());
 
+    if (cancel.isCancelled())
+    {
+        return;
+    }
+
     // Save
     ostringstream ss;
 
     try
     {
         zlib::ozlibstream ogzs(ss, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled (the file is not added)
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
 
         ogzs.close();
 
@@ -704,6 +761,11 @@ void minecraft::writeSchematicNBTFileZip(std::string fileName, zip_t *zipper, st
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            return;
+        }
+
         throw -2;
     }
 }
@@ -29,6 +29,7 @@
 #include <fstream>
 
 #include <cstring>
+#include <cstdio>
 
 using namespace std;
 using namespace mapart;
@@ -108,8 +109,10 @@ nbt::tag_compound blockToTagOffset(const mapart::MapBuildingBlock &block, vector
     return tag;
 }
 
-void minecraft::writeStructureNBTFileCompact(std::string fileName, std::vector<std::vector<mapart::MapBuildingBlock>> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, threading::Progress &progress)
+void minecraft::writeStructureNBTFileCompact(std::string fileName, std::vector<mapart::MapBuildPlan> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, threading::Progress &progress)
 {
+    const threading::CancellationToken &cancel = progress.getCancellationToken();
+
     nbt::tag_compound root;
     nbt::tag_list blocksTag;
     nbt::tag_list paletteTag;
@@ -145,27 +148,26 @@ void minecraft::writeStructureNBTFileCompact(std::string fileName, std::vector<s
 
     for (size_t chunk_i = 0; chunk_i < chunk_count; chunk_i++)
     {
-        std::vector<mapart::MapBuildingBlock> *buildData = &chunks[chunk_i];
+        const mapart::MapBuildPlan *buildData = &chunks[chunk_i];
 
         size_t offset_x = chunk_i * MAP_WIDTH;
 
-        size_t size = buildData->size();
-        for (size_t i = 0; i < size; i++)
+        for (const mapart::MapBuildingBlock block : *buildData)
         {
             // Compute max y level for size
-            int y = buildData->at(i).y + 1;
+            int y = block.y + 1;
             if (y > maxYlevel)
             {
                 maxYlevel = y;
             }
 
             // Add the blocks
-            const minecraft::BlockDescription *blockPtr = buildData->at(i).block_ptr;
+            const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
             if (blockPtr == NULL)
             {
                 // First line, no base blocks
-                blocksTag.push_back(blockToTagOffset(buildData->at(i), palette, false, offset_x, 0));
+                blocksTag.push_back(blockToTagOffset(block, palette, false, offset_x, 0));
             }
             else
             {
@@ -180,22 +182,20 @@ void minecraft::writeStructureNBTFileCompact(std::string fileName, std::vector<s
                 // Base block
                 if (supportBlocks.placeAlways || blockPtr->requiresSupportBlock)
                 {
-                    blocksTag.push_back(blockToTagOffset(buildData->at(i), palette, true, offset_x, 0));
+                    blocksTag.push_back(blockToTagOffset(block, palette, true, offset_x, 0));
                 }
 
                 // Real block
-                blocksTag.push_back(blockToTagOffset(buildData->at(i), palette, false, offset_x, 0));
+                blocksTag.push_back(blockToTagOffset(block, palette, false, offset_x, 0));
             }
         }
 
-        try
-        {
-            progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
-        }
-        catch (int)
+        if (cancel.isCancelled())
         {
             return;
         }
+
+        progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
     }
 
     // Data version and author tags
@@ -230,16 +230,33 @@ void minecraft::writeStructureNBTFileCompact(std::string fileName, std::vector<s
     try
     {
         zlib::ozlibstream ogzs(file, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            // Remove the incomplete file
+            file.close();
+            std::remove(fileName.c_str());
+            return;
+        }
+
         throw -2;
     }
 }
 
-void minecraft::writeStructureNBTFileCompactFlat(std::string fileName, std::vector<std::vector<mapart::MapBuildingBlock>> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, size_t width, minecraft::McVersion version, threading::Progress &progress)
+void minecraft::writeStructureNBTFileCompactFlat(std::string fileName, std::vector<mapart::MapBuildPlan> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, size_t width, minecraft::McVersion version, threading::Progress &progress)
 {
+    const threading::CancellationToken &cancel = progress.getCancellationToken();
+
     nbt::tag_compound root;
     nbt::tag_list blocksTag;
     nbt::tag_list paletteTag;
@@ -276,7 +293,7 @@ void minecraft::writeStructureNBTFileCompactFlat(std::string fileName, std::vect
 
     for (size_t chunk_i = 0; chunk_i < chunk_count; chunk_i++)
     {
-        std::vector<mapart::MapBuildingBlock> *buildData = &chunks[chunk_i];
+        const mapart::MapBuildPlan *buildData = &chunks[chunk_i];
 
         size_t chunk_x = chunk_i % width;
         size_t chunk_z = chunk_i / width;
@@ -284,25 +301,24 @@ void minecraft::writeStructureNBTFileCompactFlat(std::string fileName, std::vect
         size_t offset_z = chunk_z * MAP_HEIGHT;
         size_t offset_x = chunk_x * MAP_WIDTH;
 
-        size_t size = buildData->size();
-        for (size_t i = 0; i < size; i++)
+        for (const mapart::MapBuildingBlock block : *buildData)
         {
             // Compute max y level for size
-            int y = buildData->at(i).y + 1;
+            int y = block.y + 1;
             if (y > maxYlevel)
             {
                 maxYlevel = y;
             }
 
             // Add the blocks
-            const minecraft::BlockDescription *blockPtr = buildData->at(i).block_ptr;
+            const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
             if (blockPtr == NULL)
             {
                 // First line, no base blocks
                 if (chunk_z == 0)
                 {
-                    blocksTag.push_back(blockToTagOffset(buildData->at(i), palette, false, offset_x, offset_z));
+                    blocksTag.push_back(blockToTagOffset(block, palette, false, offset_x, offset_z));
                 }
             }
             else
@@ -318,22 +334,20 @@ void minecraft::writeStructureNBTFileCompactFlat(std::string fileName, std::vect
                 // Base block
                 if (supportBlocks.placeAlways || blockPtr->requiresSupportBlock)
                 {
-                    blocksTag.push_back(blockToTagOffset(buildData->at(i), palette, true, offset_x, offset_z));
+                    blocksTag.push_back(blockToTagOffset(block, palette, true, offset_x, offset_z));
                 }
 
                 // Real block
-                blocksTag.push_back(blockToTagOffset(buildData->at(i), palette, false, offset_x, offset_z));
+                blocksTag.push_back(blockToTagOffset(block, palette, false, offset_x, offset_z));
             }
         }
 
-        try
-        {
-            progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
-        }
-        catch (int)
+        if (cancel.isCancelled())
         {
             return;
         }
+
+        progress.setProgress(0, static_cast<unsigned int>(chunk_i + 1));
     }
 
     // Data version and author tags
@@ -368,15 +382,30 @@ void minecraft::writeStructureNBTFileCompactFlat(std::string fileName, std::vect
     try
     {
         zlib::ozlibstream ogzs(file, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            // Remove the incomplete file
+            file.close();
+            std::remove(fileName.c_str());
+            return;
+        }
+
         throw -2;
     }
 }
 
-void minecraft::writeStructureNBTFile(std::string fileName, std::vector<mapart::MapBuildingBlock> &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase)
+void minecraft::writeStructureNBTFile(std::string fileName, const mapart::MapBuildPlan &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase, const threading::CancellationToken &cancel)
 {
     nbt::tag_compound root;
     nbt::tag_list blocksTag;
@@ -408,23 +437,22 @@ void minecraft::writeStructureNBTFile(std::string fileName, std::vector<mapart::
     }
 
     // Blocks parsing
-    size_t size = buildData.size();
-    for (size_t i = 0; i < size; i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
         // Compute max y level for size
-        int y = buildData[i].y + 1;
+        int y = block.y + 1;
         if (y > maxYlevel)
         {
             maxYlevel = y;
         }
 
         // Add the blocks
-        const minecraft::BlockDescription *blockPtr = buildData[i].block_ptr;
+        const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
         if (blockPtr == NULL)
         {
             // First line, no base blocks
-            blocksTag.push_back(blockToTag(buildData[i], palette, false));
+            blocksTag.push_back(blockToTag(block, palette, false));
         }
         else
         {
@@ -439,13 +467,13 @@ void minecraft::writeStructureNBTFile(std::string fileName, std::vector<mapart::
             // Base block
             if (supportBlocks.placeAlways || blockPtr->requiresSupportBlock)
             {
-                blocksTag.push_back(blockToTag(buildData[i], palette, true));
+                blocksTag.push_back(blockToTag(block, palette, true));
             }
 
             // Real block
             if (!isBase)
             {
-                blocksTag.push_back(blockToTag(buildData[i], palette, false));
+                blocksTag.push_back(blockToTag(block, palette, false));
             }
         }
     }
@@ -471,6 +499,11 @@ void minecraft::writeStructureNBTFile(std::string fileName, std::vector<mapart::
     sizeTag.push_back(nbt::tag_int(MAP_HEIGHT + 1));
     root.insert("size", sizeTag.clone());
 
+    if (cancel.isCancelled())
+    {
+        return;
+    }
+
     // Save
     std::ofstream file(fileName, std::ios::binary);
 
@@ -482,15 +515,30 @@ void minecraft::writeStructureNBTFile(std::string fileName, std::vector<mapart::
     try
     {
         zlib::ozlibstream ogzs(file, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            // Remove the incomplete file
+            file.close();
+            std::remove(fileName.c_str());
+            return;
+        }
+
         throw -2;
     }
 }
 
-void minecraft::writeStructureNBTFileZip(std::string fileName, zip_t *zipper, std::vector<mapart::MapBuildingBlock> &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase)
+void minecraft::writeStructureNBTFileZip(std::string fileName, zip_t *zipper, const mapart::MapBuildPlan &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase, const threading::CancellationToken &cancel)
 {
     nbt::tag_compound root;
     nbt::tag_list blocksTag;
@@ -522,23 +570,22 @@ void minecraft::writeStructureNBTFileZip(std::string fileName, zip_t *zipper, st
     }
 
     // Blocks parsing
-    size_t size = buildData.size();
-    for (size_t i = 0; i < size; i++)
+    for (const mapart::MapBuildingBlock block : buildData)
     {
         // Compute max y level for size
-        int y = buildData[i].y + 1;
+        int y = block.y + 1;
         if (y > maxYlevel)
         {
             maxYlevel = y;
         }
 
         // Add the blocks
-        const minecraft::BlockDescription *blockPtr = buildData[i].block_ptr;
+        const minecraft::BlockDescription *blockPtr = block.block_ptr;
 
         if (blockPtr == NULL)
         {
             // First line, no base blocks
-            blocksTag.push_back(blockToTag(buildData[i], palette, false));
+            blocksTag.push_back(blockToTag(block, palette, false));
         }
         else
         {
@@ -552,13 +599,13 @@ void minecraft::writeStructureNBTFileZip(std::string fileName, zip_t *zipper, st
 
             // Base block
             if (supportBlocks.placeAlways || blockPtr->requiresSupportBlock) {
-                blocksTag.push_back(blockToTag(buildData[i], palette, true));
+                blocksTag.push_back(blockToTag(block, palette, true));
             }
 
             // Real block
             if (!isBase)
             {
-                blocksTag.push_back(blockToTag(buildData[i], palette, false));
+                blocksTag.push_back(blockToTag(block, palette, false));
             }
         }
     }
@@ -584,13 +631,25 @@ void minecraft::writeStructureNBTFileZip(std::string fileName, zip_t *zipper, st
     sizeTag.push_back(nbt::tag_int(MAP_HEIGHT + 1));
     root.insert("size", sizeTag.clone());
 
+    if (cancel.isCancelled())
+    {
+        return;
+    }
+
     // Save
     ostringstream ss;
 
     try
     {
         zlib::ozlibstream ogzs(ss, -1, true);
-        nbt::io::write_tag("", root, ogzs);
+
+        // Stops in the middle of the serialization if cancelled (the file is not added)
+        threading::CancellableOutputBuffer cancellableBuffer(ogzs, cancel);
+        std::ostream cancellableStream(&cancellableBuffer);
+        cancellableStream.exceptions(std::ios::badbit);
+
+        nbt::io::write_tag("", root, cancellableStream);
+        cancellableStream.flush();
 
         ogzs.close();
 
@@ -608,6 +667,11 @@ void minecraft::writeStructureNBTFileZip(std::string fileName, zip_t *zipper, st
     }
     catch (...)
     {
+        if (cancel.isCancelled())
+        {
+            return;
+        }
+
         throw -2;
     }
 }
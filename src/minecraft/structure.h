@@ -23,7 +23,7 @@
 
 #pragma once
 
-#include "../mapart/common.h"
+#include "../mapart/build_plan.h"
 #include "../threads/progress.h"
 #include <zip.h>
 
@@ -36,9 +36,10 @@ namespace minecraft {
      * @param  supportBlocks Support block options
      * @param  version Minecraft version
      * @param  isBase Set to true to only save the base blocks (stone) 
+     * @param  cancel Cancellation token (if cancelled, the file is not written)
      * @retval None
      */
-    void writeStructureNBTFile(std::string fileName, std::vector<mapart::MapBuildingBlock> &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase);
+    void writeStructureNBTFile(std::string fileName, const mapart::MapBuildPlan &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase, const threading::CancellationToken &cancel);
 
     /**
      * @brief  Writes structure to file (compact, single file)
@@ -50,7 +51,7 @@ namespace minecraft {
      * @param  progress progress reporter
      * @retval None
      */
-    void writeStructureNBTFileCompact(std::string fileName, std::vector<std::vector<mapart::MapBuildingBlock>> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, threading::Progress &progress);
+    void writeStructureNBTFileCompact(std::string fileName, std::vector<mapart::MapBuildPlan> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, threading::Progress &progress);
 
      /**
      * @brief  Writes structure to file (compact, single file) (for flat maps only)
@@ -63,7 +64,7 @@ namespace minecraft {
      * @param  progress progress reporter
      * @retval None
      */
-    void writeStructureNBTFileCompactFlat(std::string fileName, std::vector<std::vector<mapart::MapBuildingBlock>> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, size_t width, minecraft::McVersion version, threading::Progress &progress);
+    void writeStructureNBTFileCompactFlat(std::string fileName, std::vector<mapart::MapBuildPlan> &chunks, mapart::MapBuildingSupportBlock &supportBlocks, size_t width, minecraft::McVersion version, threading::Progress &progress);
 
     /**
      * @brief  Writes structure to file
@@ -74,7 +75,8 @@ namespace minecraft {
      * @param  supportBlocks Support block options
      * @param  version: Minecraft version
      * @param  isBase: Set to true to only save the base blocks (stone) 
+     * @param  cancel: Cancellation token (if cancelled, the file is not written)
      * @retval None
      */
-    void writeStructureNBTFileZip(std::string fileName, zip_t *zipper, std::vector<mapart::MapBuildingBlock> &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase);
+    void writeStructureNBTFileZip(std::string fileName, zip_t *zipper, const mapart::MapBuildPlan &buildData, mapart::MapBuildingSupportBlock &supportBlocks, minecraft::McVersion version, bool isBase, const threading::CancellationToken &cancel);
 }
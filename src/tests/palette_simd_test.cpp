@@ -0,0 +1,242 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Checks the SIMD kernels of the compiled palette against the linear search.
+ * Every kernel supported by the CPU is forced with setKernel, and the closest
+ * color, the 2 closest colors and their distances must be the same as
+ * minecraft::findClosestColor and minecraft::find2ClosestColors.
+ * Returns 0 on success, 1 if any result is different.
+ */
+
+#include "../mapart/palette_simd.h"
+#include "../colors/cielab.h"
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace colors;
+using namespace minecraft;
+using namespace mapart;
+
+/**
+ * @brief  Compares a compiled palette with the linear search
+ * @note
+ * @param  &palette: Compiled palette (with the kernel already set)
+ * @param  &colorSet: Color set used to build the palette
+ * @param  algo: Color distance algorithm
+ * @param  &queries: Colors to search
+ * @retval Number of results that are different
+ */
+size_t compareWithLinearSearch(const CompiledPalette &palette, const std::vector<FinalColor> &colorSet, ColorDistanceAlgorithm algo, const std::vector<Color> &queries)
+{
+    size_t mismatches = 0;
+
+    for (size_t i = 0; i < queries.size(); i++)
+    {
+        Color c = queries[i];
+
+        ClosestColorPair expected = findClosestColorPair(colorSet, c, algo);
+        ClosestColorPair actual = palette.findClosestColorPair(c);
+
+        bool same = actual.first == expected.first && actual.second == expected.second && actual.distFirst == expected.distFirst && actual.distSecond == expected.distSecond;
+
+        if (palette.findClosestColor(c) != findClosestColor(colorSet, c, algo))
+        {
+            same = false;
+        }
+
+        if (!same)
+        {
+            if (mismatches == 0)
+            {
+                cerr << "    First mismatch: (" << int(c.red) << ", " << int(c.green) << ", " << int(c.blue) << ") "
+                     << "expected " << expected.first << "/" << expected.second << " (" << expected.distFirst << ", " << expected.distSecond << ") "
+                     << "got " << actual.first << "/" << actual.second << " (" << actual.distFirst << ", " << actual.distSecond << ")" << endl;
+            }
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+/**
+ * @brief  Sets the color of an entry of the color set
+ * @note
+ * @param  &colorSet: Color set
+ * @param  i: Index
+ * @param  color: New color
+ * @retval None
+ */
+void setPaletteColor(std::vector<FinalColor> &colorSet, size_t i, Color color)
+{
+    colorSet[i].color = color;
+    cielab::rgbToLab(color, &colorSet[i].lab);
+}
+
+/**
+ * @brief  Gets the color sets to test
+ * @note   Includes palettes with repeated colors and colors at the same
+ *         distance of the queries, to test the tie resolution
+ * @param  &names: Vector to store the names of the color sets
+ * @retval The color sets
+ */
+std::vector<std::vector<FinalColor>> getTestColorSets(std::vector<std::string> &names)
+{
+    std::vector<Color> baseColors = loadBaseColors(MC_LAST_VERSION);
+    std::vector<FinalColor> fullSet = loadFinalColors(baseColors);
+    std::vector<std::vector<FinalColor>> sets;
+
+    // All the colors
+    sets.push_back(fullSet);
+    names.push_back("full");
+
+    // Some colors (not a multiple of the SIMD block)
+    sets.push_back(fullSet);
+    for (size_t i = 0; i < fullSet.size(); i++)
+    {
+        sets.back()[i].enabled = (i % 7 == 3);
+    }
+    names.push_back("sparse");
+
+    // Only one color
+    sets.push_back(fullSet);
+    for (size_t i = 0; i < fullSet.size(); i++)
+    {
+        sets.back()[i].enabled = (i == 40);
+    }
+    names.push_back("single");
+
+    // Every color repeated 3 times, the lowest index must win
+    sets.push_back(fullSet);
+    for (size_t i = 4; i < fullSet.size(); i++)
+    {
+        setPaletteColor(sets.back(), i, fullSet[4 + ((i - 4) / 3) * 3].color);
+    }
+    names.push_back("repeated");
+
+    // Pairs of colors at the same distance of the grey colors, in every lane
+    sets.push_back(fullSet);
+    for (size_t i = 4; i < fullSet.size(); i++)
+    {
+        unsigned char level = static_cast<unsigned char>(((i - 4) / 6) * 4 + 8);
+        unsigned char offset = static_cast<unsigned char>(((i - 4) % 3) + 1);
+        bool up = ((i - 4) % 6) >= 3;
+
+        Color c;
+        c.red = level;
+        c.green = up ? level + offset : level - offset;
+        c.blue = level;
+        setPaletteColor(sets.back(), i, c);
+    }
+    names.push_back("equidistant");
+
+    return sets;
+}
+
+/**
+ * @brief  Gets the colors to search
+ * @note   Random colors, the colors of the palette and all the grey colors
+ * @param  &colorSet: Color set
+ * @param  count: Number of random colors
+ * @retval The colors
+ */
+std::vector<Color> getTestQueries(const std::vector<FinalColor> &colorSet, size_t count)
+{
+    std::vector<Color> queries;
+    mt19937 rng(42);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t v = rng();
+        Color c;
+        c.red = static_cast<unsigned char>(v);
+        c.green = static_cast<unsigned char>(v >> 8);
+        c.blue = static_cast<unsigned char>(v >> 16);
+        queries.push_back(c);
+    }
+
+    for (size_t i = 0; i < colorSet.size(); i++)
+    {
+        queries.push_back(colorSet[i].color);
+    }
+
+    for (int i = 0; i < 256; i++)
+    {
+        Color c;
+        c.red = static_cast<unsigned char>(i);
+        c.green = static_cast<unsigned char>(i);
+        c.blue = static_cast<unsigned char>(i);
+        queries.push_back(c);
+    }
+
+    return queries;
+}
+
+int main()
+{
+    std::vector<std::string> names;
+    std::vector<std::vector<FinalColor>> colorSets = getTestColorSets(names);
+
+    PaletteKernel kernels[] = {PaletteKernel::Scalar, PaletteKernel::SSE41, PaletteKernel::AVX2};
+    ColorDistanceAlgorithm algos[] = {ColorDistanceAlgorithm::Euclidean, ColorDistanceAlgorithm::DeltaE};
+
+    size_t failed = 0;
+
+    for (size_t s = 0; s < colorSets.size(); s++)
+    {
+        std::vector<Color> queries = getTestQueries(colorSets[s], 20000);
+
+        for (size_t a = 0; a < 2; a++)
+        {
+            CompiledPalette palette;
+            palette.build(colorSets[s], algos[a]);
+
+            for (size_t k = 0; k < 3; k++)
+            {
+                palette.setKernel(kernels[k]);
+
+                if (palette.getKernel() != kernels[k])
+                {
+                    cout << "SKIP " << getPaletteKernelName(kernels[k]) << " (not supported by the CPU)" << endl;
+                    continue;
+                }
+
+                size_t mismatches = compareWithLinearSearch(palette, colorSets[s], algos[a], queries);
+
+                cout << (mismatches == 0 ? "OK   " : "FAIL ") << getPaletteKernelName(kernels[k]) << " "
+                     << names[s] << " " << (algos[a] == ColorDistanceAlgorithm::DeltaE ? "DeltaE" : "Euclidean")
+                     << ": " << mismatches << " mismatches in " << queries.size() << " colors" << endl;
+
+                if (mismatches > 0)
+                {
+                    failed++;
+                }
+            }
+        }
+    }
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Contention microbenchmark of threading::Progress.
+ * Many threads report their progress at the same time with setProgress,
+ * while another thread reads it with getProgress, like the progress reporter.
+ * Usage: progress-bench [threads] [calls per thread] (default: 64 200000)
+ */
+
+#include "../threads/progress.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace threading;
+
+int main(int argc, char **argv)
+{
+    unsigned int threadNum = 64;
+    unsigned int calls = 200000;
+
+    if (argc > 1)
+    {
+        threadNum = static_cast<unsigned int>(atoi(argv[1]));
+    }
+
+    if (argc > 2)
+    {
+        calls = static_cast<unsigned int>(atoi(argv[2]));
+    }
+
+    if (threadNum == 0 || calls == 0)
+    {
+        cerr << "Usage: progress-bench [threads] [calls per thread]" << endl;
+        return 1;
+    }
+
+    Progress p;
+    p.startTask("Benchmark", threadNum * calls, threadNum);
+
+    // Reader, like the progress reporter of the console and the GUI
+    std::atomic<bool> done(false);
+    unsigned long reads = 0;
+
+    std::thread reader([&p, &done, &reads]() {
+        while (!done)
+        {
+            p.getProgress();
+            reads++;
+        }
+    });
+
+    auto start = chrono::steady_clock::now();
+
+    std::vector<std::thread> writers;
+
+    for (unsigned int i = 0; i < threadNum; i++)
+    {
+        writers.push_back(std::thread([&p, i, calls]() {
+            for (unsigned int k = 1; k <= calls; k++)
+            {
+                p.setProgress(i, k);
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < writers.size(); i++)
+    {
+        writers[i].join();
+    }
+
+    auto end = chrono::steady_clock::now();
+
+    done = true;
+    reader.join();
+
+    double seconds = chrono::duration<double>(end - start).count();
+    double totalCalls = static_cast<double>(threadNum) * calls;
+    unsigned int finalProgress = p.getProgress().second;
+
+    cout << threadNum << " threads x " << calls << " setProgress: " << seconds << "s ("
+         << (seconds * 1e9 / totalCalls) << " ns per call), " << reads << " getProgress, final progress "
+         << finalProgress << "%" << endl;
+
+    return finalProgress == 100 ? 0 : 1;
+}
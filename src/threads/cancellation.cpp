@@ -0,0 +1,88 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "cancellation.h"
+
+using namespace std;
+using namespace threading;
+
+CancellationToken::CancellationToken()
+{
+    cancelled.store(false);
+}
+
+void CancellationToken::cancel()
+{
+    cancelled.store(true, std::memory_order_relaxed);
+}
+
+void CancellationToken::reset()
+{
+    cancelled.store(false, std::memory_order_relaxed);
+}
+
+CancellableOutputBuffer::CancellableOutputBuffer(std::ostream &target, const CancellationToken &cancel) : target(target), cancel(cancel)
+{
+    setp(buffer, buffer + CANCELLABLE_BUFFER_SIZE);
+}
+
+bool CancellableOutputBuffer::flushBuffer()
+{
+    if (cancel.isCancelled())
+    {
+        setp(buffer, buffer + CANCELLABLE_BUFFER_SIZE); // Discard
+        return false;
+    }
+
+    std::ptrdiff_t count = pptr() - pbase();
+
+    if (count > 0)
+    {
+        target.write(pbase(), count);
+    }
+
+    setp(buffer, buffer + CANCELLABLE_BUFFER_SIZE);
+
+    return static_cast<bool>(target);
+}
+
+CancellableOutputBuffer::int_type CancellableOutputBuffer::overflow(int_type ch)
+{
+    if (!flushBuffer())
+    {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(ch, traits_type::eof()))
+    {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+
+    return traits_type::not_eof(ch);
+}
+
+int CancellableOutputBuffer::sync()
+{
+    return flushBuffer() ? 0 : -1;
+}
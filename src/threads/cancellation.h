@@ -0,0 +1,111 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <ostream>
+#include <streambuf>
+
+// Size of the buffer of the cancellable streams (the token is checked each time it is flushed)
+#define CANCELLABLE_BUFFER_SIZE (4096)
+
+namespace threading
+{
+    /**
+     * @brief  Cancellation request, shared by the threads of a task
+     * @note   Checking it is a relaxed atomic load, so it can be checked often
+     *         (per row, tile or chunk) to stop the work early.
+     * @retval None
+     */
+    class CancellationToken
+    {
+    public:
+        CancellationToken();
+
+        CancellationToken(const CancellationToken &) = delete;
+        CancellationToken &operator=(const CancellationToken &) = delete;
+
+        /**
+         * @brief  Requests the cancellation
+         * @note
+         * @retval None
+         */
+        void cancel();
+
+        /**
+         * @brief  Clears the cancellation request
+         * @note
+         * @retval None
+         */
+        void reset();
+
+        /**
+         * @brief  Checks if the cancellation was requested
+         * @note
+         * @retval True if cancelled
+         */
+        inline bool isCancelled() const
+        {
+            return cancelled.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<bool> cancelled;
+    };
+
+    /**
+     * @brief  Output buffer that stops writing when the task is cancelled
+     * @note   Writes to another stream in blocks of CANCELLABLE_BUFFER_SIZE bytes.
+     *         Once cancelled, writes fail, so a stream with exceptions for badbit
+     *         stops in the middle of a long serialization.
+     *         The stream must be flushed before destroying the buffer (the rest is discarded).
+     * @retval None
+     */
+    class CancellableOutputBuffer : public std::streambuf
+    {
+    public:
+        /**
+         * @brief  Creates the buffer
+         * @note
+         * @param  &target: Stream to write to
+         * @param  &cancel: Cancellation token
+         * @retval None
+         */
+        CancellableOutputBuffer(std::ostream &target, const CancellationToken &cancel);
+
+        CancellableOutputBuffer(const CancellableOutputBuffer &) = delete;
+        CancellableOutputBuffer &operator=(const CancellableOutputBuffer &) = delete;
+
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+
+    private:
+        std::ostream &target;
+        const CancellationToken &cancel;
+        char buffer[CANCELLABLE_BUFFER_SIZE];
+
+        bool flushBuffer();
+    };
+}
@@ -31,16 +31,17 @@ Progress::Progress()
     task_name = "Initializing...";
     total_threads = 0;
     ended = false;
-    terminated = false;
     total_progress = 0;
 }
 
 void Progress::reset() {
+    mtx.lock();
     task_name = "Initializing...";
     total_threads = 0;
-    ended = false;
-    terminated = false;
     total_progress = 0;
+    mtx.unlock();
+    ended = false;
+    cancellation.reset();
 }
 
 bool Progress::hasEnded()
@@ -50,16 +51,20 @@ bool Progress::hasEnded()
 
 void Progress::startTask(std::string name, unsigned int totalP, unsigned int threadsNum)
 {
-    if (terminated) {
+    if (cancellation.isCancelled()) {
         throw -1;
     }
     mtx.lock();
     task_name = name;
     total_threads = threadsNum;
-    progress.resize(total_threads);
+    if (progress.size() < total_threads)
+    {
+        // Atomics can not be moved, so the counters are allocated again
+        progress = std::vector<ThreadProgress>(total_threads);
+    }
     for (size_t i = 0; i < total_threads; i++)
     {
-        progress[i] = 0;
+        progress[i].value.store(0, std::memory_order_relaxed);
     }
     total_progress = totalP;
     mtx.unlock();
@@ -67,12 +72,7 @@ void Progress::startTask(std::string name, unsigned int totalP, unsigned int thr
 
 void Progress::setProgress(unsigned int thread_num, unsigned int p)
 {
-    if (terminated) {
-        throw -1;
-    }
-    mtx.lock();
-    progress[thread_num] = p;
-    mtx.unlock();
+    progress[thread_num].value.store(p, std::memory_order_relaxed);
 }
 
 std::pair<std::string, unsigned int> Progress::getProgress()
@@ -87,7 +87,7 @@ std::pair<std::string, unsigned int> Progress::getProgress()
     {
         for (size_t i = 0; i < total_threads; i++)
         {
-            t += progress[i];
+            t += progress[i].value.load(std::memory_order_relaxed);
         }
         t = (t * 100) / total_progress;
     }
@@ -109,9 +109,13 @@ void Progress::setEnded() {
 }
 
 void Progress::terminate() {
-    terminated = true;
+    cancellation.cancel();
 }
 
 bool Progress::isTerminated() {
-    return terminated;
+    return cancellation.isCancelled();
+}
+
+const CancellationToken &Progress::getCancellationToken() {
+    return cancellation;
 }
@@ -26,17 +26,37 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <atomic>
+
+#include "cancellation.h"
 
 #define NO_PROGRESS (101)
 
 namespace threading {
+    /**
+     * @brief  Progress of a thread
+     * @note   Aligned to its own cache line, so threads do not invalidate each other's progress
+     * @retval None
+     */
+    struct alignas(64) ThreadProgress {
+        std::atomic<unsigned int> value;
+    };
+
+    /**
+     * @brief  Progress of a task, reported by multiple threads
+     * @note   setProgress does not lock: each thread writes its own atomic counter,
+     *         and getProgress adds them. The mutex only protects the task (name and threads).
+     *         terminate() cancels the token returned by getCancellationToken, which the
+     *         workers check to stop early. startTask throws -1 if the task was terminated.
+     * @retval None
+     */
     class Progress {
         private:
-            bool ended;
-            bool terminated;
+            std::atomic<bool> ended;
+            CancellationToken cancellation;
             unsigned int total_threads;
             std::string task_name;
-            std::vector<unsigned int> progress;
+            std::vector<ThreadProgress> progress;
             unsigned int total_progress;
             std::mutex mtx;
         public:
@@ -52,6 +72,8 @@ namespace threading {
 
             void terminate();
 
+            const CancellationToken &getCancellationToken();
+
             void reset();
     };
 }
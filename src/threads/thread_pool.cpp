@@ -0,0 +1,282 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+#define NO_WORKER (std::numeric_limits<size_t>::max())
+
+using namespace std;
+using namespace threading;
+
+// Pool and queue of the current thread, if it is a worker
+thread_local const ThreadPool *currentPool = NULL;
+thread_local size_t currentWorker = NO_WORKER;
+
+// Pool shared by all the stages
+std::unique_ptr<ThreadPool> sharedPool;
+std::mutex sharedPoolMtx;
+
+ThreadPool::ThreadPool(size_t threadNum) : queues(max(threadNum, static_cast<size_t>(1)) - 1)
+{
+    queued.store(0);
+    nextQueue.store(0);
+    stopping = false;
+
+    // The caller of run() is the other thread
+    for (size_t i = 0; i < queues.size(); i++)
+    {
+        workers.push_back(std::thread(&ThreadPool::workerFunc, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    sleepMtx.lock();
+    stopping = true;
+    sleepMtx.unlock();
+    wake.notify_all();
+
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+size_t ThreadPool::size() const
+{
+    return workers.size() + 1;
+}
+
+void ThreadPool::run(size_t count, std::function<void(size_t)> func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (workers.empty())
+    {
+        // Only the caller
+        std::exception_ptr error;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        return;
+    }
+
+    ThreadPoolJob job;
+    job.func = std::move(func);
+    job.remaining.store(count);
+
+    size_t own = (currentPool == this) ? currentWorker : NO_WORKER;
+
+    if (own != NO_WORKER)
+    {
+        // Nested job, the other workers steal the tasks
+        ThreadPoolQueue &queue = queues[own];
+        queue.mtx.lock();
+        for (size_t i = 0; i < count; i++)
+        {
+            queue.tasks.push_back({&job, i});
+        }
+        queue.mtx.unlock();
+    }
+    else
+    {
+        // Spread the tasks over the queues
+        size_t first = nextQueue.fetch_add(1, std::memory_order_relaxed);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            ThreadPoolQueue &queue = queues[(first + i) % queues.size()];
+            queue.mtx.lock();
+            queue.tasks.push_back({&job, i});
+            queue.mtx.unlock();
+        }
+    }
+
+    queued.fetch_add(count);
+
+    // Wake the workers (locking prevents missing the wake up of a worker about to sleep)
+    sleepMtx.lock();
+    sleepMtx.unlock();
+    wake.notify_all();
+
+    // Help while there are tasks left
+    ThreadPoolTask task;
+
+    while (job.remaining.load() > 0 && takeTask(own, task))
+    {
+        executeTask(task);
+    }
+
+    std::unique_lock<std::mutex> lock(job.mtx);
+    job.done.wait(lock, [&job] { return job.remaining.load() == 0; });
+
+    if (job.error)
+    {
+        std::rethrow_exception(job.error);
+    }
+}
+
+void ThreadPool::workerFunc(size_t id)
+{
+    currentPool = this;
+    currentWorker = id;
+
+    ThreadPoolTask task;
+
+    while (true)
+    {
+        if (takeTask(id, task))
+        {
+            executeTask(task);
+            continue;
+        }
+
+        // Park until there are new tasks
+        std::unique_lock<std::mutex> lock(sleepMtx);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::takeTask(size_t id, ThreadPoolTask &task)
+{
+    if (queued.load() == 0)
+    {
+        return false;
+    }
+
+    if (id != NO_WORKER)
+    {
+        // Newest task of the own queue
+        ThreadPoolQueue &queue = queues[id];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Steal the oldest task of another queue
+    size_t start = (id != NO_WORKER) ? (id + 1) : 0;
+
+    for (size_t i = 0; i < queues.size(); i++)
+    {
+        ThreadPoolQueue &queue = queues[(start + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mtx);
+
+        if (!queue.tasks.empty())
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::executeTask(const ThreadPoolTask &task)
+{
+    ThreadPoolJob *job = task.job;
+    std::exception_ptr error;
+
+    try
+    {
+        job->func(task.index);
+    }
+    catch (...)
+    {
+        error = std::current_exception();
+    }
+
+    // The job can not end (and be destroyed) while its mutex is locked
+    std::lock_guard<std::mutex> lock(job->mtx);
+
+    if (error && !job->error)
+    {
+        job->error = error;
+    }
+
+    if (job->remaining.fetch_sub(1) == 1)
+    {
+        job->done.notify_all();
+    }
+}
+
+void threading::initThreadPool(size_t threadNum)
+{
+    threadNum = max(threadNum, static_cast<size_t>(1));
+
+    std::lock_guard<std::mutex> lock(sharedPoolMtx);
+
+    if (!sharedPool || sharedPool->size() != threadNum)
+    {
+        sharedPool.reset();
+        sharedPool.reset(new ThreadPool(threadNum));
+    }
+}
+
+ThreadPool &threading::getThreadPool()
+{
+    std::lock_guard<std::mutex> lock(sharedPoolMtx);
+
+    if (!sharedPool)
+    {
+        sharedPool.reset(new ThreadPool(max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1))));
+    }
+
+    return *sharedPool;
+}
@@ -0,0 +1,157 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threading
+{
+    /**
+     * @brief  Group of tasks started by ThreadPool::run
+     * @retval None
+     */
+    struct ThreadPoolJob
+    {
+        std::function<void(size_t)> func;
+
+        // Tasks not finished yet
+        std::atomic<size_t> remaining;
+
+        // First exception thrown by a task
+        std::exception_ptr error;
+
+        std::mutex mtx;
+        std::condition_variable done;
+    };
+
+    /**
+     * @brief  Task of a job (index of the task inside the job)
+     * @retval None
+     */
+    struct ThreadPoolTask
+    {
+        ThreadPoolJob *job;
+        size_t index;
+    };
+
+    /**
+     * @brief  Queue of tasks of a worker
+     * @note   Aligned to its own cache line, so workers do not invalidate each other's queues
+     * @retval None
+     */
+    struct alignas(64) ThreadPoolQueue
+    {
+        std::mutex mtx;
+        std::deque<ThreadPoolTask> tasks;
+    };
+
+    /**
+     * @brief  Work-stealing pool of threads
+     * @note   Each worker takes the newest task of its own queue, and steals the oldest
+     *         task of the other queues when it is empty. Idle workers sleep until a task is added.
+     *         The thread calling run() also executes tasks while it waits, so a pool
+     *         for N threads starts N - 1 workers, and jobs can be nested.
+     * @retval None
+     */
+    class ThreadPool
+    {
+    public:
+        /**
+         * @brief  Creates the pool
+         * @note
+         * @param  threadNum: Number of threads running the tasks, including the caller of run()
+         * @retval None
+         */
+        ThreadPool(size_t threadNum);
+
+        /**
+         * @brief  Stops the workers
+         * @note   No job can be running
+         * @retval None
+         */
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /**
+         * @brief  Gets the number of threads
+         * @note
+         * @retval Number of workers plus the calling thread
+         */
+        size_t size() const;
+
+        /**
+         * @brief  Runs func(0), ..., func(count - 1) in the pool, and waits for all of them
+         * @note   The tasks may run at the same time, in any order. If a task throws,
+         *         the first exception is thrown again here after all the tasks end.
+         * @param  count: Number of tasks
+         * @param  func: Function of the tasks, receives the index of the task
+         * @retval None
+         */
+        void run(size_t count, std::function<void(size_t)> func);
+
+    private:
+        std::vector<std::thread> workers;
+        std::vector<ThreadPoolQueue> queues;
+
+        // Number of tasks in the queues
+        std::atomic<size_t> queued;
+
+        // Queue for the next task added from outside the pool
+        std::atomic<size_t> nextQueue;
+
+        bool stopping;
+        std::mutex sleepMtx;
+        std::condition_variable wake;
+
+        void workerFunc(size_t id);
+
+        bool takeTask(size_t id, ThreadPoolTask &task);
+
+        void executeTask(const ThreadPoolTask &task);
+    };
+
+    /**
+     * @brief  Sets the number of threads of the shared pool
+     * @note   Call it before starting any task (the pool is created again if the size changes)
+     * @param  threadNum: Number of threads
+     * @retval None
+     */
+    void initThreadPool(size_t threadNum);
+
+    /**
+     * @brief  Gets the pool shared by all the stages
+     * @note   Created with one thread per core if initThreadPool was not called
+     * @retval The pool
+     */
+    ThreadPool &getThreadPool();
+}
@@ -24,6 +24,7 @@
 #include "basedir.h"
 
 #include <cstring>
+#include <cstdlib>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -129,4 +130,43 @@ namespace tools
     }
 
 #endif
+
+    std::string getCacheDir()
+    {
+#if defined(_WIN32)
+        const char *localAppData = getenv("LOCALAPPDATA");
+
+        if (localAppData == NULL || localAppData[0] == '\0')
+        {
+            return std::string("");
+        }
+
+        return std::string(localAppData) + std::string("\\ImageToMapMC\\cache");
+#else
+        const char *home = getenv("HOME");
+
+#if defined(__APPLE__)
+        if (home == NULL || home[0] == '\0')
+        {
+            return std::string("");
+        }
+
+        return std::string(home) + std::string("/Library/Caches/ImageToMapMC");
+#else
+        const char *xdgCache = getenv("XDG_CACHE_HOME");
+
+        if (xdgCache != NULL && xdgCache[0] == '/')
+        {
+            return std::string(xdgCache) + std::string("/ImageToMapMC");
+        }
+
+        if (home == NULL || home[0] == '\0')
+        {
+            return std::string("");
+        }
+
+        return std::string(home) + std::string("/.cache/ImageToMapMC");
+#endif
+#endif
+    }
 }
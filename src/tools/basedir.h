@@ -40,4 +40,11 @@ namespace tools
      * @retval 
      */
     std::string getExecutableDir();
+
+    /**
+     * @brief  Get the directory to store cache files of the current user
+     * @note   The directory may not exist
+     * @retval Path to the directory, or an empty string if unknown
+     */
+    std::string getCacheDir();
 }
@@ -0,0 +1,83 @@
+/*
+ * This file is part of ImageToMapMC project
+ *
+ * Copyright (c) 2021 Agustin San Roman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace tools
+{
+    /**
+     * @brief  Read only memory mapped file
+     * @note   The file is unmapped when the object is destroyed
+     * @retval None
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        /**
+         * @brief  Maps a file
+         * @note   Closes the previously mapped file
+         * @param  &path: Path to the file
+         * @retval True if success, false if the file could not be mapped
+         */
+        bool open(const std::string &path);
+
+        /**
+         * @brief  Unmaps the file
+         * @note
+         * @retval None
+         */
+        void close();
+
+        /**
+         * @brief  Gets the contents of the file
+         * @note
+         * @retval Pointer to the first byte, or NULL if not mapped
+         */
+        const unsigned char *data() const;
+
+        /**
+         * @brief  Gets the size of the file
+         * @note
+         * @retval Size in bytes
+         */
+        size_t size() const;
+
+    private:
+        const unsigned char *mappedData;
+        size_t mappedSize;
+
+#if defined(_WIN32)
+        void *fileHandle;
+        void *mappingHandle;
+#endif
+    };
+}
@@ -80,7 +80,7 @@ wxImagePanel::wxImagePanel(wxFrame *parent) : wxPanel(parent)
 const colors::Color bgColor1{200, 200, 200};
 const colors::Color bgColor2{150, 150, 150};
 
-void wxImagePanel::setColors(const std::vector<const minecraft::FinalColor *> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
+void wxImagePanel::setColors(const std::vector<map_color_t> &colorsMatrix, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
 {
     colorsMutex.Lock();
 
@@ -151,13 +151,14 @@ void wxImagePanel::setColors(const std::vector<const minecraft::FinalColor *> &c
     size_t j = 0;
     for (size_t i = 0; i < size; i++)
     {
-        colors::Color color = colorsMatrix[i]->color;
+        const minecraft::FinalColor &finalColor = colorSet[colorsMatrix[i]];
+        colors::Color color = finalColor.color;
 
         rawData[j++] = color.red;
         rawData[j++] = color.green;
         rawData[j++] = color.blue;
 
-        if (colorsMatrix[i]->baseColorIndex == (short)minecraft::McColors::NONE || (preserveTransparency && transparencyMatrix[i]))
+        if (finalColor.baseColorIndex == (short)minecraft::McColors::NONE || (preserveTransparency && transparencyMatrix.isTransparent(i)))
         {
             alphaData[i] = 0;
         }
@@ -175,7 +176,7 @@ void wxImagePanel::setColors(const std::vector<const minecraft::FinalColor *> &c
     this->Refresh();
 }
 
-void wxImagePanel::setColors(const std::vector<colors::Color> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
+void wxImagePanel::setColors(const std::vector<colors::Color> &colorsMatrix, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
 {
     colorsMutex.Lock();
 
@@ -252,7 +253,7 @@ void wxImagePanel::setColors(const std::vector<colors::Color> &colorsMatrix, con
         rawData[j++] = color.green;
         rawData[j++] = color.blue;
 
-        alphaData[i] = preserveTransparency ? (transparencyMatrix[i] ? 0 : 255) : 255;
+        alphaData[i] = preserveTransparency ? (transparencyMatrix.isTransparent(i) ? 0 : 255) : 255;
     }
 
     bitmap = new wxBitmap(image);
@@ -462,12 +463,12 @@ DisplayImageFrame::~DisplayImageFrame()
 {
 }
 
-void DisplayImageFrame::setColors(const std::vector<const minecraft::FinalColor *> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
+void DisplayImageFrame::setColors(const std::vector<map_color_t> &colorsMatrix, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
 {
-    drawPane->setColors(colorsMatrix, transparencyMatrix, width, height, preserveTransparency);
+    drawPane->setColors(colorsMatrix, colorSet, transparencyMatrix, width, height, preserveTransparency);
 }
 
-void DisplayImageFrame::setColors(const std::vector<colors::Color> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
+void DisplayImageFrame::setColors(const std::vector<colors::Color> &colorsMatrix, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency)
 {
     drawPane->setColors(colorsMatrix, transparencyMatrix, width, height, preserveTransparency);
 }
@@ -478,12 +479,12 @@ void DisplayImageFrame::OnSize(wxSizeEvent &event)
     drawPane->Refresh();
 }
 
-void widgets::displayMapImage(std::vector<const minecraft::FinalColor *> &colorsMatrix, wxApp &app)
+void widgets::displayMapImage(const std::vector<map_color_t> &colorsMatrix, const std::vector<minecraft::FinalColor> &colorSet, wxApp &app)
 {
     wxInitAllImageHandlers();
     DisplayImageFrame *frame = new DisplayImageFrame(NULL, (string("Rendering minecraft map: ") + string(app.argv[1])), wxPoint(50, 50), wxSize(800, 600));
-    std::vector<bool> transparency(0);
-    frame->setColors(colorsMatrix, transparency, MAP_WIDTH, MAP_HEIGHT, false);
+    mapart::TransparencyMask transparency;
+    frame->setColors(colorsMatrix, colorSet, transparency, MAP_WIDTH, MAP_HEIGHT, false);
     frame->defaultFile = string(app.argv[1]) + string(".png");
     frame->Show(true);
 }
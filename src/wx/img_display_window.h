@@ -51,8 +51,8 @@ public:
 
     void render(wxDC &dc);
 
-    void setColors(const std::vector<const minecraft::FinalColor *> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
-    void setColors(const std::vector<colors::Color> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
+    void setColors(const std::vector<map_color_t> &colorsMatrix, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
+    void setColors(const std::vector<colors::Color> &colorsMatrix, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
 
     DECLARE_EVENT_TABLE()
 };
@@ -66,8 +66,8 @@ public:
     DisplayImageFrame(wxWindow *parent, const wxString &title, const wxPoint &pos, const wxSize &size);
     ~DisplayImageFrame();
 
-    void setColors(const std::vector<const minecraft::FinalColor *> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
-    void setColors(const std::vector<colors::Color> &colorsMatrix, const std::vector<bool> &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
+    void setColors(const std::vector<map_color_t> &colorsMatrix, const std::vector<minecraft::FinalColor> &colorSet, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
+    void setColors(const std::vector<colors::Color> &colorsMatrix, const mapart::TransparencyMask &transparencyMatrix, size_t width, size_t height, bool preserveTransparency);
 
     void OnShowContextMenu(wxContextMenuEvent &event);
     void OnContextMenuSelected(wxCommandEvent &event);
@@ -80,5 +80,5 @@ private:
 
 namespace widgets
 {
-    void displayMapImage(std::vector<const minecraft::FinalColor *> &colorsMatrix, wxApp &app);
+    void displayMapImage(const std::vector<map_color_t> &colorsMatrix, const std::vector<minecraft::FinalColor> &colorSet, wxApp &app);
 }
@@ -32,6 +32,7 @@
 #include "../minecraft/structure.h"
 #include "../minecraft/mcfunction.h"
 #include "../tools/open_desktop.h"
+#include "../threads/thread_pool.h"
 
 #include <fstream>
 
@@ -106,6 +107,7 @@ enum StatusBatIdentifiers
 #define COLOR_METHOD_ID_PREFIX (1600)
 #define BUILD_METHOD_ID_PREFIX (1700)
 #define DITHERING_ID_PREFIX (1800)
+#define DIFFUSION_MODE_ID_PREFIX (1900)
 
 BEGIN_EVENT_TABLE(MainWindow, wxFrame)
 EVT_MENU(ID_File_New, MainWindow::newProject)
@@ -126,6 +128,7 @@ EVT_MENU_RANGE(VERSION_ID_PREFIX, VERSION_ID_PREFIX + 99, MainWindow::onChangeVe
 EVT_MENU_RANGE(COLOR_METHOD_ID_PREFIX, COLOR_METHOD_ID_PREFIX + 99, MainWindow::onChangeColorAlgo)
 EVT_MENU_RANGE(BUILD_METHOD_ID_PREFIX, BUILD_METHOD_ID_PREFIX + 99, MainWindow::onChangeBuildMethod)
 EVT_MENU_RANGE(DITHERING_ID_PREFIX, DITHERING_ID_PREFIX + 99, MainWindow::onChangeDithering)
+EVT_MENU_RANGE(DIFFUSION_MODE_ID_PREFIX, DIFFUSION_MODE_ID_PREFIX + 99, MainWindow::onChangeDiffusionMode)
 EVT_MENU(wxID_EXIT, MainWindow::onExit)
 EVT_MENU(ID_Blocks_Custom, MainWindow::onCustomBlocks)
 EVT_SIZE(MainWindow::OnSize)
@@ -169,6 +172,11 @@ int getIdForDitheringMenu(DitheringMethod a)
     return DITHERING_ID_PREFIX + (short)a;
 }
 
+int getIdForDiffusionModeMenu(ErrorDiffusionMode a)
+{
+    return DIFFUSION_MODE_ID_PREFIX + (short)a;
+}
+
 MainWindow::MainWindow() : wxFrame(NULL, wxID_ANY, string("Minecraft Map Art Tool - v" APP_VERSION), wxPoint(50, 50), wxSize(800, 600))
 {
     materialsWindow = NULL;
@@ -194,6 +202,7 @@ MainWindow::MainWindow() : wxFrame(NULL, wxID_ANY, string("Minecraft Map Art Too
 
     // Worker thread
     threadNum = max((unsigned int)1, std::thread::hardware_concurrency());
+    threading::initThreadPool(threadNum); // Created once, so previews do not start threads
     this->workerThread = new WorkerThread(this, threadNum);
     this->workerThread->Run();
 
@@ -270,6 +279,13 @@ MainWindow::MainWindow() : wxFrame(NULL, wxID_ANY, string("Minecraft Map Art Too
     menuDithering->AppendRadioItem(getIdForDitheringMenu(DitheringMethod::Bayer22), "&Bayer (2x2)\t7", "Applies filter to create the illusion of more colors");
     menuDithering->AppendRadioItem(getIdForDitheringMenu(DitheringMethod::Bayer44), "&Bayer (4x4)\t8", "Applies filter to create the illusion of more colors");
     menuDithering->AppendRadioItem(getIdForDitheringMenu(DitheringMethod::Ordered33), "&Ordered (3x3)\t9", "Applies filter to create the illusion of more colors");
+    menuDithering->AppendRadioItem(getIdForDitheringMenu(DitheringMethod::Bayer88), "Bayer (8x8)", "Applies filter to create the illusion of more colors");
+    menuDithering->AppendRadioItem(getIdForDitheringMenu(DitheringMethod::Bayer1616), "Bayer (16x16)", "Applies filter to create the illusion of more colors");
+    menuDithering->AppendRadioItem(getIdForDitheringMenu(DitheringMethod::BlueNoise), "B&lue noise", "Applies a noise filter to create the illusion of more colors, without visible patterns");
+    menuDithering->AppendSeparator();
+    menuDithering->AppendRadioItem(getIdForDiffusionModeMenu(ErrorDiffusionMode::Exact), "&Exact error diffusion", "The error is diffused through the whole image")->Check(true);
+    menuDithering->AppendRadioItem(getIdForDiffusionModeMenu(ErrorDiffusionMode::Tiled), "&Tiled error diffusion", "The error is confined to each map. Faster with multiple cores");
+    menuDithering->AppendRadioItem(getIdForDiffusionModeMenu(ErrorDiffusionMode::TiledSeams), "Tiled error diffusion with &seams", "The error is confined to each map, carrying the error from the borders of the previous maps");
     menuBar->Append(menuDithering, "&Dithering");
 
     // Build method
@@ -471,6 +487,14 @@ void MainWindow::onChangeDithering(wxCommandEvent &evt)
     RequestPreviewGeneration();
 }
 
+void MainWindow::onChangeDiffusionMode(wxCommandEvent &evt)
+{
+    project.diffusionMode = static_cast<ErrorDiffusionMode>(evt.GetId() - DIFFUSION_MODE_ID_PREFIX);
+    dirty = true;
+    updateConfigStatusText();
+    RequestPreviewGeneration();
+}
+
 void MainWindow::onSetTransparencyYes(wxCommandEvent &evt)
 {
     project.preserveTransparency = true;
@@ -1179,6 +1203,23 @@ void MainWindow::updateConfigStatusText()
         ss << mapart::ditheringMethodToString(project.ditheringMethod);
     }
 
+    switch (project.ditheringMethod)
+    {
+    case DitheringMethod::FloydSteinberg:
+    case DitheringMethod::MinAvgErr:
+    case DitheringMethod::Burkes:
+    case DitheringMethod::SierraLite:
+    case DitheringMethod::Stucki:
+    case DitheringMethod::Atkinson:
+        if (project.diffusionMode != ErrorDiffusionMode::Exact)
+        {
+            ss << " (" << mapart::errorDiffusionModeToString(project.diffusionMode) << ")";
+        }
+        break;
+    default:
+        break;
+    }
+
     ss << ", ";
 
     switch (project.buildMethod)
@@ -1240,7 +1281,10 @@ void MainWindow::updateMenuBarRadios()
         int menuIndex = menusIndexes[m];
         for (int i = 0; i < GetMenuBar()->GetMenu(menuIndex)->GetMenuItems().size(); i++)
         {
-            GetMenuBar()->GetMenu(menuIndex)->GetMenuItems()[i]->Check(false);
+            if (GetMenuBar()->GetMenu(menuIndex)->GetMenuItems()[i]->IsCheckable())
+            {
+                GetMenuBar()->GetMenu(menuIndex)->GetMenuItems()[i]->Check(false);
+            }
         }
     }
 
@@ -1284,10 +1328,21 @@ void MainWindow::updateMenuBarRadios()
     case DitheringMethod::Ordered33:
         GetMenuBar()->GetMenu(ditheringMenuIndex)->GetMenuItems()[9]->Check(true);
         break;
+    case DitheringMethod::Bayer88:
+        GetMenuBar()->GetMenu(ditheringMenuIndex)->GetMenuItems()[10]->Check(true);
+        break;
+    case DitheringMethod::Bayer1616:
+        GetMenuBar()->GetMenu(ditheringMenuIndex)->GetMenuItems()[11]->Check(true);
+        break;
+    case DitheringMethod::BlueNoise:
+        GetMenuBar()->GetMenu(ditheringMenuIndex)->GetMenuItems()[12]->Check(true);
+        break;
     default:
         GetMenuBar()->GetMenu(ditheringMenuIndex)->GetMenuItems()[0]->Check(true);
     }
 
+    GetMenuBar()->Check(getIdForDiffusionModeMenu(project.diffusionMode), true);
+
     switch (project.buildMethod)
     {
     case MapBuildMethod::Staircased:
@@ -1338,7 +1393,7 @@ void MainWindow::onWorkerError(wxCommandEvent &event)
 void MainWindow::onWorkerPreviewDone(wxCommandEvent &event)
 {
     MapArtPreviewData data = this->workerThread->GetPreviewData();
-    previewPanel->setColors(data.colors, data.transparency, data.width, data.height, data.preserveTransparency);
+    previewPanel->setColors(data.colors, data.colorSet, data.transparency, data.width, data.height, data.preserveTransparency);
 }
 void MainWindow::onWorkerMaterialsGiven(wxCommandEvent &event)
 {
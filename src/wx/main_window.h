@@ -64,6 +64,7 @@ public:
     void onChangeVersion(wxCommandEvent &evt);
     void onChangeColorAlgo(wxCommandEvent &evt);
     void onChangeDithering(wxCommandEvent &evt);
+    void onChangeDiffusionMode(wxCommandEvent &evt);
     void onChangeBuildMethod(wxCommandEvent &evt);
     void onSetTransparencyYes(wxCommandEvent &evt);
     void onSetTransparencyNo(wxCommandEvent &evt);
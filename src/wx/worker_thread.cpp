@@ -52,6 +52,7 @@ WorkerThread::WorkerThread(wxEvtHandler *pParent, int threadNum) : wxThread(wxTH
     this->threadNum = threadNum;
     taskType = TaskType::None;
     cancellable = false;
+    imageCacheValid = false;
     progress.reset();
     progress.setEnded();
 }
@@ -395,13 +396,38 @@ void WorkerThread::requestExportFunc(mapart::MapArtProject &project, std::string
     sem.Post();
 }
 
-/* Workers */
+/* Image preparation */
 
-void WorkerThread::GeneratePreview(mapart::MapArtProject &copyProject)
+bool WorkerThread::isImageCacheValid(mapart::MapArtProject &copyProject)
 {
-    try
+    if (!imageCacheValid)
     {
-        progress.startTask("Preparing image...", 0, 0);
+        return false;
+    }
+
+    return imageCacheProject.width == copyProject.width &&
+           imageCacheProject.height == copyProject.height &&
+           imageCacheProject.resize_width == copyProject.resize_width &&
+           imageCacheProject.resize_height == copyProject.resize_height &&
+           imageCacheProject.saturation == copyProject.saturation &&
+           imageCacheProject.brightness == copyProject.brightness &&
+           imageCacheProject.contrast == copyProject.contrast &&
+           imageCacheProject.transparencyTolerance == copyProject.transparencyTolerance &&
+           imageCacheProject.background.red == copyProject.background.red &&
+           imageCacheProject.background.green == copyProject.background.green &&
+           imageCacheProject.background.blue == copyProject.background.blue &&
+           imageCacheProject.image_data == copyProject.image_data &&
+           imageCacheProject.image_alpha == copyProject.image_alpha;
+}
+
+const mapart::ImageColorMatrix &WorkerThread::PrepareImage(mapart::MapArtProject &copyProject, int *width, int *height)
+{
+    progress.startTask("Preparing image...", 0, 0);
+
+    if (!isImageCacheValid(copyProject))
+    {
+        imageCacheValid = false;
+
         wxImage imageCopy = copyProject.toImage();
 
         if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
@@ -409,11 +435,35 @@ void WorkerThread::GeneratePreview(mapart::MapArtProject &copyProject)
             imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
         }
 
+        imageCache = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &imageCacheWidth, &imageCacheHeight);
+
+        tools::editImage(imageCache.colors, imageCacheWidth, imageCacheHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+
+        imageCacheProject = copyProject;
+        imageCacheValid = true;
+    }
+
+    // The L*ab plane is only used by DeltaE, compute it the first time it is needed
+    if (copyProject.colorDistanceAlgorithm == ColorDistanceAlgorithm::DeltaE && imageCache.lab.size() != imageCache.colors.size())
+    {
+        imageCache.lab = computeLabMatrix(imageCache.colors, threadNum);
+    }
+
+    *width = imageCacheWidth;
+    *height = imageCacheHeight;
+
+    return imageCache;
+}
+
+/* Workers */
+
+void WorkerThread::GeneratePreview(mapart::MapArtProject &copyProject)
+{
+    try
+    {
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -437,10 +487,19 @@ void WorkerThread::GeneratePreview(mapart::MapArtProject &copyProject)
             countsMats[i] = 0;
         }
 
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+        const colors::Lab *labMatrix = originalImageColorMatrix.lab.size() == originalImageColorMatrix.colors.size() ? originalImageColorMatrix.lab.data() : NULL;
+
+        previewColors.resize(originalImageWidth * originalImageHeight);
+        generateMapArt(colorSet, originalImageColorMatrix.colors.data(), labMatrix, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, previewScratch, previewColors.data(), countsMats, NULL);
 
         returnDataMutex.Lock();
-        previewData = MapArtPreviewData(mapArtColorMatrix, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency);
+        // The buffer of the previous preview is reused by the next one
+        previewData.colors.swap(previewColors);
+        previewData.colorSet = colorSet;
+        previewData.transparency = originalImageColorMatrix.transparency;
+        previewData.width = originalImageWidth;
+        previewData.height = originalImageHeight;
+        previewData.preserveTransparency = copyProject.preserveTransparency;
         countMaterials = countsMats;
         returnDataMutex.Unlock();
 
@@ -462,19 +521,9 @@ void WorkerThread::ExportMaterials(mapart::MapArtProject &copyProject, std::stri
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -492,7 +541,15 @@ void WorkerThread::ExportMaterials(mapart::MapArtProject &copyProject, std::stri
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
@@ -522,7 +579,7 @@ void WorkerThread::ExportMaterials(mapart::MapArtProject &copyProject, std::stri
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 progress.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(copyProject.version, blockSet, colorSet, mapArtTiles, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
 
                 // Add to materials list
                 materials.addBlocks(buildingBlocks);
@@ -553,19 +610,9 @@ void WorkerThread::ExportMaterialsSplit(mapart::MapArtProject &copyProject, std:
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -583,7 +630,15 @@ void WorkerThread::ExportMaterialsSplit(mapart::MapArtProject &copyProject, std:
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
@@ -614,7 +669,7 @@ void WorkerThread::ExportMaterialsSplit(mapart::MapArtProject &copyProject, std:
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 progress.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(copyProject.version, blockSet, colorSet, mapArtTiles, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
 
                 // Add to materials list
                 materials.addBlocks(buildingBlocks);
@@ -656,19 +711,9 @@ void WorkerThread::ExportMaps(mapart::MapArtProject &copyProject, std::string &c
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -685,7 +730,15 @@ void WorkerThread::ExportMaps(mapart::MapArtProject &copyProject, std::string &c
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
@@ -700,7 +753,7 @@ void WorkerThread::ExportMaps(mapart::MapArtProject &copyProject, std::string &c
             for (int mapX = 0; mapX < mapsCountX; mapX++)
             {
                 // Get map data
-                std::vector<map_color_t> mapDataToSave = getMapDataFromColorMatrix(mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ);
+                std::vector<map_color_t> mapDataToSave = getMapDataFromColorMatrix(mapArtTiles, mapX, mapZ);
 
                 // Save to file
                 stringstream ss;
@@ -721,6 +774,11 @@ void WorkerThread::ExportMaps(mapart::MapArtProject &copyProject, std::string &c
 
                 total++;
                 progress.setProgress(0, total);
+
+                if (progress.isTerminated())
+                {
+                    throw -1;
+                }
             }
         }
 
@@ -742,19 +800,9 @@ void WorkerThread::ExportMapsZip(mapart::MapArtProject &copyProject, std::string
     zip_t *zipper = nullptr;
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -771,7 +819,15 @@ void WorkerThread::ExportMapsZip(mapart::MapArtProject &copyProject, std::string
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Create zip container for the files
         int errorp;
@@ -796,7 +852,7 @@ void WorkerThread::ExportMapsZip(mapart::MapArtProject &copyProject, std::string
             for (int mapX = 0; mapX < mapsCountX; mapX++)
             {
                 // Get map data
-                std::vector<map_color_t> mapDataToSave = getMapDataFromColorMatrix(mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ);
+                std::vector<map_color_t> mapDataToSave = getMapDataFromColorMatrix(mapArtTiles, mapX, mapZ);
 
                 // Save to file
                 stringstream ss;
@@ -816,6 +872,11 @@ void WorkerThread::ExportMapsZip(mapart::MapArtProject &copyProject, std::string
 
                 total++;
                 progress.setProgress(0, total);
+
+                if (progress.isTerminated())
+                {
+                    throw -1;
+                }
             }
         }
 
@@ -839,19 +900,9 @@ void WorkerThread::ExportStruct(mapart::MapArtProject &copyProject, std::string
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -870,7 +921,15 @@ void WorkerThread::ExportStruct(mapart::MapArtProject &copyProject, std::string
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
@@ -887,7 +946,7 @@ void WorkerThread::ExportStruct(mapart::MapArtProject &copyProject, std::string
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 progress.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(copyProject.version, blockSet, colorSet, mapArtTiles, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
 
                 // Save as structure file
                 stringstream ss2;
@@ -904,8 +963,8 @@ void WorkerThread::ExportStruct(mapart::MapArtProject &copyProject, std::string
 
                 try
                 {
-                    writeStructureNBTFile(outFilePath.string(), buildingBlocks, supportBlockOptions, copyProject.version, false);
-                    writeStructureNBTFile(outBaseFilePath.string(), buildingBlocks, supportBlockOptions, copyProject.version, true);
+                    writeStructureNBTFile(outFilePath.string(), buildingBlocks, supportBlockOptions, copyProject.version, false, progress.getCancellationToken());
+                    writeStructureNBTFile(outBaseFilePath.string(), buildingBlocks, supportBlockOptions, copyProject.version, true, progress.getCancellationToken());
                 }
                 catch (...)
                 {
@@ -914,6 +973,11 @@ void WorkerThread::ExportStruct(mapart::MapArtProject &copyProject, std::string
                 }
 
                 total++;
+
+                if (progress.isTerminated())
+                {
+                    throw -1;
+                }
             }
         }
 
@@ -931,19 +995,9 @@ void WorkerThread::ExportStructSingleFile(mapart::MapArtProject &copyProject, st
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -962,33 +1016,26 @@ void WorkerThread::ExportStructSingleFile(mapart::MapArtProject &copyProject, st
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
         int mapsCountZ = originalImageHeight / MAP_HEIGHT;
 
-        progress.startTask("Building maps...", 0, 0);
-        int total = 0;
         int totalMapsCount = mapsCountX * mapsCountZ;
+        progress.startTask("Building maps...", static_cast<unsigned int>(totalMapsCount * MAP_WIDTH), threadNum);
 
-        std::vector<std::vector<mapart::MapBuildingBlock>> chunks;
-
-        for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
-        {
-            for (int mapX = 0; mapX < mapsCountX; mapX++)
-            {
-                stringstream ss;
-                ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
-                progress.startTask(ss.str(), MAP_WIDTH, threadNum);
-
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
-
-                chunks.push_back(buildingBlocks);
-
-                total++;
-            }
-        }
+        // All the maps at once, in parallel
+        std::vector<mapart::MapBuildPlan> chunks;
+        mapart::buildMaps(copyProject.version, blockSet, colorSet, mapArtTiles, copyProject.buildMethod, threadNum, progress, chunks);
 
         progress.startTask("Generating structure file...", static_cast<unsigned int>(totalMapsCount), 1);
 
@@ -1022,19 +1069,9 @@ void WorkerThread::ExportStructZip(mapart::MapArtProject &copyProject, std::stri
     zip_t *zipper = nullptr;
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -1053,7 +1090,15 @@ void WorkerThread::ExportStructZip(mapart::MapArtProject &copyProject, std::stri
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Create zip container for the files
         int errorp;
@@ -1080,7 +1125,7 @@ void WorkerThread::ExportStructZip(mapart::MapArtProject &copyProject, std::stri
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 progress.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(copyProject.version, blockSet, colorSet, mapArtTiles, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
 
                 // Save as structure file
                 stringstream ss2;
@@ -1095,8 +1140,8 @@ void WorkerThread::ExportStructZip(mapart::MapArtProject &copyProject, std::stri
 
                 try
                 {
-                    writeStructureNBTFileZip(fPath, zipper, buildingBlocks, supportBlockOptions, copyProject.version, false);
-                    writeStructureNBTFileZip(fPathBase, zipper, buildingBlocks, supportBlockOptions, copyProject.version, true);
+                    writeStructureNBTFileZip(fPath, zipper, buildingBlocks, supportBlockOptions, copyProject.version, false, progress.getCancellationToken());
+                    writeStructureNBTFileZip(fPathBase, zipper, buildingBlocks, supportBlockOptions, copyProject.version, true, progress.getCancellationToken());
                 }
                 catch (...)
                 {
@@ -1105,6 +1150,11 @@ void WorkerThread::ExportStructZip(mapart::MapArtProject &copyProject, std::stri
                 }
 
                 total++;
+
+                if (progress.isTerminated())
+                {
+                    throw -1;
+                }
             }
         }
         zip_close(zipper); // Close zipper
@@ -1127,19 +1177,9 @@ void WorkerThread::ExportSchematicSingleFile(mapart::MapArtProject &copyProject,
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -1158,33 +1198,26 @@ void WorkerThread::ExportSchematicSingleFile(mapart::MapArtProject &copyProject,
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
         int mapsCountZ = originalImageHeight / MAP_HEIGHT;
 
-        progress.startTask("Building maps...", 0, 0);
-        int total = 0;
         int totalMapsCount = mapsCountX * mapsCountZ;
+        progress.startTask("Building maps...", static_cast<unsigned int>(totalMapsCount * MAP_WIDTH), threadNum);
 
-        std::vector<std::vector<mapart::MapBuildingBlock>> chunks;
-
-        for (int mapZ = 0; mapZ < mapsCountZ; mapZ++)
-        {
-            for (int mapX = 0; mapX < mapsCountX; mapX++)
-            {
-                stringstream ss;
-                ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
-                progress.startTask(ss.str(), MAP_WIDTH, threadNum);
-
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
-
-                chunks.push_back(buildingBlocks);
-
-                total++;
-            }
-        }
+        // All the maps at once, in parallel
+        std::vector<mapart::MapBuildPlan> chunks;
+        mapart::buildMaps(copyProject.version, blockSet, colorSet, mapArtTiles, copyProject.buildMethod, threadNum, progress, chunks);
 
         progress.startTask("Generating schematic file...", static_cast<unsigned int>(totalMapsCount), 1);
 
@@ -1218,19 +1251,9 @@ void WorkerThread::ExportSchematicZip(mapart::MapArtProject &copyProject, std::s
     zip_t *zipper = nullptr;
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -1249,7 +1272,15 @@ void WorkerThread::ExportSchematicZip(mapart::MapArtProject &copyProject, std::s
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Create zip container for the files
         int errorp;
@@ -1276,7 +1307,7 @@ void WorkerThread::ExportSchematicZip(mapart::MapArtProject &copyProject, std::s
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 progress.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(copyProject.version, blockSet, colorSet, mapArtTiles, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
 
                 // Save as structure file
                 stringstream ss2;
@@ -1291,8 +1322,8 @@ void WorkerThread::ExportSchematicZip(mapart::MapArtProject &copyProject, std::s
 
                 try
                 {
-                    writeSchematicNBTFileZip(fPath, zipper, buildingBlocks, supportBlockOptions, copyProject.version, false);
-                    writeSchematicNBTFileZip(fPathBase, zipper, buildingBlocks, supportBlockOptions, copyProject.version, true);
+                    writeSchematicNBTFileZip(fPath, zipper, buildingBlocks, supportBlockOptions, copyProject.version, false, progress.getCancellationToken());
+                    writeSchematicNBTFileZip(fPathBase, zipper, buildingBlocks, supportBlockOptions, copyProject.version, true, progress.getCancellationToken());
                 }
                 catch (...)
                 {
@@ -1301,6 +1332,11 @@ void WorkerThread::ExportSchematicZip(mapart::MapArtProject &copyProject, std::s
                 }
 
                 total++;
+
+                if (progress.isTerminated())
+                {
+                    throw -1;
+                }
             }
         }
         zip_close(zipper); // Close zipper
@@ -1323,19 +1359,9 @@ void WorkerThread::ExportFunc(mapart::MapArtProject &copyProject, std::string &c
 {
     try
     {
-        progress.startTask("Preparing image...", 0, 0);
-        wxImage imageCopy = copyProject.toImage();
-
-        if (copyProject.resize_width > 0 && copyProject.resize_height > 0)
-        {
-            imageCopy.Rescale(copyProject.resize_width, copyProject.resize_height);
-        }
-
         int originalImageWidth;
         int originalImageHeight;
-        mapart::ImageColorMatrix originalImageColorMatrix = loadColorMatrixFromImageAndPad(imageCopy, copyProject.background, copyProject.transparencyTolerance, &originalImageWidth, &originalImageHeight);
-
-        tools::editImage(originalImageColorMatrix.colors, originalImageWidth, originalImageHeight, copyProject.saturation, copyProject.contrast, copyProject.brightness);
+        const mapart::ImageColorMatrix &originalImageColorMatrix = PrepareImage(copyProject, &originalImageWidth, &originalImageHeight);
 
         progress.startTask("Loading minecraft colors...", 0, 0);
         std::vector<colors::Color> baseColors = minecraft::loadBaseColors(copyProject.version);
@@ -1352,7 +1378,15 @@ void WorkerThread::ExportFunc(mapart::MapArtProject &copyProject, std::string &c
         applyBuildRestrictions(colorSet, copyProject.buildMethod);
 
         progress.startTask("Adjusting colors...", originalImageHeight, threadNum);
-        std::vector<const minecraft::FinalColor *> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, threadNum, progress, countsMats);
+
+        // Each map is stored contiguous, for the export
+        mapart::TiledMatrix<map_color_t> mapArtTiles;
+
+        {
+            // The matrix by rows is freed once copied
+            std::vector<map_color_t> mapArtColorMatrix = generateMapArt(colorSet, originalImageColorMatrix.colors, originalImageColorMatrix.lab, originalImageColorMatrix.transparency, originalImageWidth, originalImageHeight, copyProject.preserveTransparency, copyProject.colorDistanceAlgorithm, copyProject.ditheringMethod, copyProject.diffusionMode, threadNum, progress, countsMats);
+            mapArtTiles.load(mapArtColorMatrix, originalImageWidth, originalImageHeight);
+        }
 
         // Compute total maps
         int mapsCountX = originalImageWidth / MAP_WIDTH;
@@ -1369,7 +1403,7 @@ void WorkerThread::ExportFunc(mapart::MapArtProject &copyProject, std::string &c
                 ss << "Building map (" << (total + 1) << "/" << totalMapsCount << ")...";
                 progress.startTask(ss.str(), MAP_WIDTH, threadNum);
 
-                std::vector<mapart::MapBuildingBlock> buildingBlocks = mapart::buildMap(copyProject.version, blockSet, mapArtColorMatrix, originalImageWidth, originalImageHeight, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
+                mapart::MapBuildPlan buildingBlocks = mapart::buildMap(copyProject.version, blockSet, colorSet, mapArtTiles, mapX, mapZ, copyProject.buildMethod, threadNum, progress);
 
                 // Save as structure file
                 stringstream ss2;
@@ -1380,7 +1414,7 @@ void WorkerThread::ExportFunc(mapart::MapArtProject &copyProject, std::string &c
 
                 try
                 {
-                    writeMcFunctionFile(outFilePath.string(), buildingBlocks, copyProject.version);
+                    writeMcFunctionFile(outFilePath.string(), buildingBlocks, copyProject.version, progress.getCancellationToken());
                 }
                 catch (...)
                 {
@@ -1389,6 +1423,11 @@ void WorkerThread::ExportFunc(mapart::MapArtProject &copyProject, std::string &c
                 }
 
                 total++;
+
+                if (progress.isTerminated())
+                {
+                    throw -1;
+                }
             }
         }
 
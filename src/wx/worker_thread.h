@@ -104,8 +104,22 @@ private:
     std::vector<size_t> countMaterials;
     mapart::MapArtPreviewData previewData;
 
+    // Working memory and result buffer of the preview, reused by every generation
+    mapart::MapArtScratch previewScratch;
+    std::vector<map_color_t> previewColors;
+
+    // Prepared image, reused while the image and its adjustments do not change
+    bool imageCacheValid;
+    mapart::MapArtProject imageCacheProject;
+    mapart::ImageColorMatrix imageCache;
+    int imageCacheWidth;
+    int imageCacheHeight;
+
     void OnError(std::string msg);
 
+    bool isImageCacheValid(mapart::MapArtProject &copyProject);
+    const mapart::ImageColorMatrix &PrepareImage(mapart::MapArtProject &copyProject, int *width, int *height);
+
     // Tasks
     void GeneratePreview(mapart::MapArtProject &copyProject);
 